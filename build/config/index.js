@@ -59,6 +59,12 @@ module.exports = {
         dest: 'com.jibo.PixiAnimate/publish'
     },
 
+    buildPublishCli: {
+        src: 'src/extension/publish/cli.js',
+        name: 'cli.js',
+        dest: 'com.jibo.PixiAnimate/publish'
+    },
+
     buildSpritesheets: {
         src: 'src/extension/publish/spritesheets/',
         name: 'spritesheets.js',
@@ -0,0 +1,10 @@
+module.exports = function(gulp, options, plugins) {
+    gulp.task('build-publish-cli', function() {
+        return plugins.build(
+            gulp,
+            options.buildPublishCli,
+            plugins, 
+            options.argv.buildDebug
+        );
+    });
+};
\ No newline at end of file
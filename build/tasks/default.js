@@ -29,6 +29,7 @@ module.exports = function(gulp, options, plugins) {
 
         tasks.push(
             'build-publish',
+            'build-publish-cli',
             'build-dialog',
             'build-preview-app',
             'build-preview',
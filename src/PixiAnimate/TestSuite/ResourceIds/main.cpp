@@ -0,0 +1,141 @@
+//
+//  main.cpp
+//  PixiAnimate.mp
+//
+//  Times ResourcePalette's id lookups at 100 to 100k resources: the
+//  exported check runs for every frame command, the add once per resource.
+//  Each mode runs on its own:
+//
+//     testapp list    linear search of a vector, as before ResourceIdSet
+//     testapp ids     ResourceIdSet
+//     testapp set     std::set
+//
+
+#include "ResourceIdSet.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <set>
+#include <vector>
+
+// Document sizes, in resources, each timed on its own
+static const FCM::U_Int32 SIZES[] = { 100, 1000, 10000, 100000 };
+
+// Lookups timed at each size
+static const FCM::U_Int32 LOOKUP_COUNT = 200000;
+
+// One in this many ids is above the direct range, each one a set entry
+static const FCM::U_Int32 SPARSE_EVERY = 20;
+
+struct ListIds
+{
+	std::vector<FCM::U_Int32> ids;
+
+	void Insert(FCM::U_Int32 id)
+	{
+		ids.push_back(id);
+	}
+
+	bool Contains(FCM::U_Int32 id) const
+	{
+		return std::find(ids.begin(), ids.end(), id) != ids.end();
+	}
+};
+
+struct SetIds
+{
+	std::set<FCM::U_Int32> ids;
+
+	void Insert(FCM::U_Int32 id)
+	{
+		ids.insert(id);
+	}
+
+	bool Contains(FCM::U_Int32 id) const
+	{
+		return ids.find(id) != ids.end();
+	}
+};
+
+struct DirectIds
+{
+	PixiJS::ResourceIdSet ids;
+
+	void Insert(FCM::U_Int32 id)
+	{
+		ids.Insert(id);
+	}
+
+	bool Contains(FCM::U_Int32 id) const
+	{
+		return ids.Contains(id);
+	}
+};
+
+// Like a publish, every id is checked before it's added, then the
+// frame commands look them up again. Only those lookups are timed.
+template <class Ids>
+static void Time(const char* name, const std::vector<FCM::U_Int32>& order)
+{
+	Ids ids;
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		if (!ids.Contains(order[i]))
+		{
+			ids.Insert(order[i]);
+		}
+	}
+
+	FCM::U_Int32 found = 0;
+	clock_t start = clock();
+	for (FCM::U_Int32 i = 0; i < LOOKUP_COUNT; i++)
+	{
+		found += ids.Contains(order[(i * 7919) % order.size()]) ? 1 : 0;
+	}
+	clock_t end = clock();
+
+	double seconds = (double)(end - start) / CLOCKS_PER_SEC;
+	std::cout << name << ": " << order.size() << " ids, "
+		<< seconds * 1e9 / LOOKUP_COUNT << " ns per lookup, "
+		<< found << " found" << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+	const char* mode = argc > 1 ? argv[1] : "ids";
+
+	srand(1);
+	for (size_t s = 0; s < sizeof(SIZES) / sizeof(SIZES[0]); s++)
+	{
+		// Sequential ids as the SDK hands them out, with a few far apart
+		std::vector<FCM::U_Int32> order;
+		for (FCM::U_Int32 i = 0; i < SIZES[s]; i++)
+		{
+			if (i % SPARSE_EVERY == SPARSE_EVERY - 1)
+			{
+				order.push_back(PixiJS::ResourceIdSet::MAX_DIRECT_ID + 1 + (FCM::U_Int32)rand());
+			}
+			else
+			{
+				order.push_back(i);
+			}
+		}
+
+		if (strcmp(mode, "list") == 0)
+		{
+			Time<ListIds>("list", order);
+		}
+		else if (strcmp(mode, "set") == 0)
+		{
+			Time<SetIds>("set", order);
+		}
+		else
+		{
+			Time<DirectIds>("ids", order);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,105 @@
+//
+//  GradientAtlas.h
+//  PixiAnimate.mp
+//
+
+#ifndef GRADIENT_ATLAS_H_
+#define GRADIENT_ATLAS_H_
+
+#include "FCMTypes.h"
+#include "Utils/DOMTypes.h"
+#include "FillStyle/IGradientFillStyle.h"
+#include <map>
+#include <string>
+#include <vector>
+
+/* -------------------------------------------------- Class Decl */
+
+namespace PixiJS
+{
+	// Gradient fills baked into small textures, packed onto shelves of one
+	// RGBA image. Linear gradients are a single row ramp, radial gradients a
+	// tile covering the fill. Identical textures are only packed once.
+	class GradientAtlas
+	{
+	public:
+
+		GradientAtlas();
+
+		~GradientAtlas();
+
+		void Clear();
+
+		// Bake a ramp of width texels, the first sampling the gradient at t0
+		// and the last at t1, where 0 and 1 are the ends of the gradient.
+		// x and y are the first texel, returns false if the atlas is full.
+		bool AddLinearRamp(
+			const std::vector<DOM::Utils::GRADIENT_COLOR_POINT>& stops,
+			DOM::FillStyle::GradientSpread spread,
+			FCM::Double t0,
+			FCM::Double t1,
+			FCM::U_Int32 width,
+			FCM::U_Int32& x,
+			FCM::U_Int32& y);
+
+		// Bake a width by height tile of a radial gradient with its unit circle
+		// at the origin and its focal point at (focal, 0). Corner texels sample
+		// (x0, y0) and (x1, y1), returns false if the atlas is full.
+		bool AddRadialTile(
+			const std::vector<DOM::Utils::GRADIENT_COLOR_POINT>& stops,
+			DOM::FillStyle::GradientSpread spread,
+			FCM::Double focal,
+			FCM::Double x0,
+			FCM::Double y0,
+			FCM::Double x1,
+			FCM::Double y1,
+			FCM::U_Int32 width,
+			FCM::U_Int32 height,
+			FCM::U_Int32& x,
+			FCM::U_Int32& y);
+
+		bool IsEmpty() const;
+
+		FCM::U_Int32 GetWidth() const;
+
+		// Height of the packed shelves, the saved image is no taller
+		FCM::U_Int32 GetHeight() const;
+
+		// Write the atlas as an uncompressed PNG
+		bool Save(const std::string& path) const;
+
+		// Largest linear ramp and radial tile that are baked
+		static const FCM::U_Int32 MAX_RAMP_WIDTH = 256;
+
+		static const FCM::U_Int32 MAX_TILE_SIZE = 128;
+
+	private:
+
+		// Pack a tile, or find the same one already packed
+		bool Place(FCM::U_Int32 width, FCM::U_Int32 height, FCM::U_Int32& x, FCM::U_Int32& y);
+
+		// Color of the gradient at t, after the spread is applied
+		void Sample(
+			const std::vector<DOM::Utils::GRADIENT_COLOR_POINT>& stops,
+			DOM::FillStyle::GradientSpread spread,
+			FCM::Double t,
+			FCM::Byte* pixel);
+
+		// RGBA rows of the atlas, only as tall as the shelves
+		std::vector<FCM::Byte> m_pixels;
+
+		// The tile being baked, before it is packed
+		std::vector<FCM::Byte> m_tile;
+
+		FCM::U_Int32 m_shelfX;
+
+		FCM::U_Int32 m_shelfY;
+
+		FCM::U_Int32 m_shelfHeight;
+
+		// Packed tiles by the hash of their pixels and size
+		std::map<std::pair<FCM::U_Int64, FCM::U_Int32>, std::pair<FCM::U_Int32, FCM::U_Int32> > m_tiles;
+	};
+};
+
+#endif // GRADIENT_ATLAS_H_
@@ -13,9 +13,12 @@
 #include "FCMTypes.h"
 #include "IOutputWriter.h"
 #include "Utils.h"
+#include "Triangulator.h"
+#include "GradientAtlas.h"
 #include <string>
 #include <vector>
 #include <map>
+#include <fstream>
 
 #define MAX_RETRY_ATTEMPT               10
 
@@ -23,6 +26,16 @@ class JSONNode;
 
 namespace PixiJS
 {
+	class PublishWorker;
+
+	struct IMAGE_MANIFEST_ENTRY
+	{
+		std::string exportPath;
+		FCM::S_Int32 height;
+		FCM::S_Int32 width;
+		FCM::U_Int64 fileHash;
+	};
+
 	class OutputWriter : public IOutputWriter
 	{
 	public:
@@ -182,6 +195,7 @@ namespace PixiJS
 			bool html,
 			bool libs,
 			bool images,
+			bool reuseImages,
 			bool sounds,
 			bool compactShapes,
 			bool compressJS,
@@ -189,10 +203,28 @@ namespace PixiJS
 			bool loopTimeline,
 			bool spritesheets,
 			int spritesheetSize,
-			double spritesheetScale);
+			double spritesheetScale,
+			double tweenTolerance,
+			int transformPrecision,
+			bool animationTracks,
+			bool triangulateFills,
+			PublishWorker* pPublishWorker);
 
 		virtual ~OutputWriter();
 
+		// Decimal places of the positions timelines are written with
+		int GetTransformPrecision();
+
+		// If timelines are written with per-instance animation tracks
+		bool GetAnimationTracks();
+
+		// Keyframe tweens of a timeline, by the name the SDK gives it
+		// to EndDefineTimeline, empty for the stage
+		void SetTweenSpans(const std::string& timelineName, const TWEEN_SPAN_LIST& spans);
+
+		// Delete the files kept between publishes of this output
+		static void RemoveCache(const std::string& basePath, const std::string& outputFile);
+
 		// Start of a path
 		virtual FCM::Result StartDefinePath();
 
@@ -207,25 +239,122 @@ namespace PixiJS
 
 	private:
 
-		FCM::Boolean GetImageExportFileName(const std::string& libPathName, std::string& name);
+		// Top-level arrays of the data file, in the order they're written
+		enum OutputSection
+		{
+			SHAPES_SECTION = 0,
+			BITMAPS_SECTION,
+			SOUNDS_SECTION,
+			TEXTS_SECTION,
+			TIMELINES_SECTION,
+			SECTION_COUNT
+		};
+
+		// Open a temporary file for each section
+		void OpenSections();
+
+		// Serialize a completed item and append it to its section
+		void WriteToSection(OutputSection section, const JSONNode& node);
+
+		// Append an already serialized item to its section
+		void WriteToSection(OutputSection section, const std::string& content);
+
+		// Join the sections and the _meta trailer into the data file
+		void CloseSections(const JSONNode& meta);
+
+		// Close and delete any temporary section files
+		void RemoveSections();
+
+		// Export a bitmap unless the same file was exported by a previous publish
+		FCM::Result ExportImage(
+			const std::string& libPathName,
+			const std::string& exportPath,
+			FCM::S_Int32 height,
+			FCM::S_Int32 width,
+			DOM::LibraryItem::PIMediaItem pMediaItem);
+
+		bool HashFile(const std::string& path, FCM::U_Int64& hash);
+
+		void ReadImageManifest();
+
+		void WriteImageManifest();
+
+		// Load the document hash of the previous publish
+		void ReadCache();
 
-		void SetImageExportFileName(const std::string& libPathName, const std::string& name);
+		// Save the document hash of this publish for the next one
+		void WriteCache();
 
-		void Save(const std::string &filePath, const std::string &content);
+		// Append an opcode to the packed path data
+		void WritePathCommand(unsigned char command);
+
+		// Append a point to the packed path data, relative to the last point
+		void WritePathPoint(const DOM::Utils::POINT2D& point);
+
+		// Append a signed value to the packed path data as a varint
+		void WritePathValue(FCM::S_Int32 value);
+
+		// Base64 node of the packed path data for the current fill or stroke
+		JSONNode GetPathData();
+
+		// Append a point to the flattened outline of the current fill
+		void AddMeshPoint(FCM::Double x, FCM::Double y);
+
+		// Append a quadratic curve, split into as many lines as its curvature needs
+		void AddMeshCurve(
+			const DOM::Utils::POINT2D& from,
+			const DOM::Utils::POINT2D& control,
+			const DOM::Utils::POINT2D& to);
+
+		// Triangulate the current fill into a mesh node, false if it has no triangles
+		bool GetMeshData(JSONNode& mesh);
+
+		// Keep the gradient of the current fill, so it can be baked once the fill is meshed
+		void SetGradient(
+			bool radial,
+			DOM::FillStyle::GradientSpread spread,
+			const DOM::Utils::MATRIX2D& matrix,
+			FCM::Double focal);
+
+		// Bake the gradient of the current fill into the atlas, with the atlas pixel
+		// of each mesh vertex as Float32 u and v pairs. False if it didn't fit.
+		bool BakeGradient(std::string& uvs);
+
+		// The bitmap of the current fill under each mesh vertex, as Float32 u and v
+		// pairs where 0 to 1 spans the image
+		void GetBitmapUVs(std::string& uvs);
+
+		FCM::Boolean GetImageExportFileName(const std::string& libPathName, std::string& name, std::string& ext);
+
+		void SetImageExportFileName(const std::string& libPathName, const std::string& name, const std::string& ext);
 
 		bool SaveFromTemplate(const std::string &templatePath, const std::string &outputPath);
 
-		JSONNode* m_pRootNode;
+		// Takes the JSON nodes of this publish, declared first so it's open before
+		// any member allocates a node. Only nodes made on the publishing thread use it.
+		JSONNodePool m_nodePool;
+
+		std::fstream m_sectionFiles[SECTION_COUNT];
+
+		std::string m_sectionPaths[SECTION_COUNT];
+
+		FCM::U_Int32 m_sectionCounts[SECTION_COUNT];
 
-		JSONNode* m_pShapeArray;
+		std::string m_cacheFile;
 
-		JSONNode* m_pTimelineArray;
+		std::string m_imageManifestFile;
 
-		JSONNode* m_pBitmapArray;
+		// Images exported by previous publishes, by library item name
+		std::map<std::string, IMAGE_MANIFEST_ENTRY> m_imageManifest;
 
-		JSONNode* m_pSoundArray;
+		FCM::U_Int32 m_imagesExported;
 
-		JSONNode* m_pTextArray;
+		FCM::U_Int32 m_imagesSkipped;
+
+		// Combined hash of every fragment and setting in the document
+		FCM::U_Int64 m_documentHash;
+
+		FCM::U_Int64 m_cachedDocumentHash;
 
 		JSONNode*  m_shapeElem;
 
@@ -245,10 +374,91 @@ namespace PixiJS
 
 		JSONNode*  m_stopPointArray;
 
-		JSONNode*  m_pathCmdArray;
+		std::string m_pathData;
+
+		FCM::S_Int32 m_pathX;
+
+		FCM::S_Int32 m_pathY;
+
+		FCM::U_Int32 m_pathBytes;
+
+		FCM::U_Int32 m_segmentCount;
+
+		FCM::Double m_segmentTime;
 
 		bool       m_firstSegment;
 
+		// Outline then holes of the current fill, flattened to x and y pairs
+		std::vector<FCM::Double> m_meshCoords;
+
+		// Vertex each hole of the current fill starts at
+		std::vector<FCM::U_Int32> m_meshHoles;
+
+		std::vector<FCM::U_Int32> m_meshTriangles;
+
+		Triangulator m_triangulator;
+
+		// Segments are flattened into the mesh, only while defining a fill
+		bool m_meshFill;
+
+		FCM::U_Int32 m_meshCount;
+
+		FCM::U_Int32 m_meshTriangleCount;
+
+		// Fills left to the path data, with too many vertices for 16-bit indices
+		FCM::U_Int32 m_meshSkipped;
+
+		FCM::Double m_meshTime;
+
+		// Gradient of the current fill or stroke, only baked for meshed fills
+		bool m_gradient;
+
+		bool m_gradientRadial;
+
+		DOM::FillStyle::GradientSpread m_gradientSpread;
+
+		std::vector<DOM::Utils::GRADIENT_COLOR_POINT> m_gradientStops;
+
+		// Maps shape coordinates to the gradient's, where its ends or circle are at 1
+		DOM::Utils::MATRIX2D m_gradientInverse;
+
+		// Pixels across one gradient unit, along its x and y
+		FCM::Double m_gradientScaleX;
+
+		FCM::Double m_gradientScaleY;
+
+		FCM::Double m_gradientFocal;
+
+		// Mesh vertices in gradient coordinates, reused between fills
+		std::vector<FCM::Double> m_gradientCoords;
+
+		GradientAtlas m_gradientAtlas;
+
+		FCM::U_Int32 m_gradientsBaked;
+
+		// Gradients drawn with their first color, on strokes or fills that weren't meshed
+		FCM::U_Int32 m_gradientsSkipped;
+
+		// Bitmap of the current fill or stroke, only mapped onto meshed fills
+		bool m_bitmap;
+
+		// Clipped bitmaps stretch their edges past the image, the others repeat
+		bool m_bitmapClipped;
+
+		std::string m_bitmapName;
+
+		// Maps shape coordinates to the image's pixels
+		DOM::Utils::MATRIX2D m_bitmapInverse;
+
+		FCM::S_Int32 m_bitmapWidth;
+
+		FCM::S_Int32 m_bitmapHeight;
+
+		FCM::U_Int32 m_bitmapsMeshed;
+
+		// Bitmaps drawn black, on strokes or fills that weren't meshed
+		FCM::U_Int32 m_bitmapsSkipped;
+
 		FCM::U_Int32 m_framerate;
 
 		FCM::U_Int32 m_stageHeight;
@@ -261,7 +471,23 @@ namespace PixiJS
 
 		FCM::PIFCMCallback m_pCallback;
 
-		std::map<std::string, std::string> m_imageMap;
+		// Runs the compiler when Electron isn't needed, may be NULL
+		PublishWorker* m_pPublishWorker;
+
+		// Sections are sent to the worker as they are written
+		bool m_streaming;
+
+		// Name and extension of each image exported, by library path
+		std::map<std::string, std::pair<std::string, std::string> > m_imageMap;
+
+		// Serialized shape paths and the first resource that used them, by hash
+		typedef std::multimap<FCM::U_Int64, std::pair<std::string, FCM::U_Int32> > ShapeMap;
+
+		ShapeMap m_shapeMap;
+
+		FCM::U_Int32 m_shapeAliasCount;
+
+		FCM::U_Int32 m_shapeAliasBytes;
 
 		FCM::U_Int32 m_symbolNameLabel;
 
@@ -297,6 +523,20 @@ namespace PixiJS
 
 		double m_spritesheetScale;
 
+		// Pixels a fitted tween may stray from the frames it replaces
+		double m_tweenTolerance;
+
+		// Decimal places of the positions in display transforms
+		int m_transformPrecision;
+
+		// Write display properties as per-instance tracks
+		bool m_animationTracks;
+
+		// Write a triangle mesh with each fill
+		bool m_triangulateFills;
+
+		std::map<std::string, TWEEN_SPAN_LIST> m_tweenSpans;
+
 		bool m_spritesheets;
 
 		bool m_html;
@@ -305,6 +545,10 @@ namespace PixiJS
 
 		bool m_images;
 
+		// Skip exporting images whose file from the last publish is untouched.
+		// The SDK gives no way to tell if the library bitmap itself changed.
+		bool m_reuseImages;
+
 		bool m_sounds;
 
 		bool m_compactShapes;
@@ -50,6 +50,9 @@
 /* The Node script to run to compile the output */
 #define NODE_COMPILER                       "publish/index.js";
 
+/* The same compiler without Electron, for output without spritesheets */
+#define NODE_COMPILER_CLI                   "publish/cli.js"
+
 /* Electron application to run preview */
 #define PREVIEW_APP                         "preview";
 
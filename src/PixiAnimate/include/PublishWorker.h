@@ -0,0 +1,117 @@
+//
+//  PublishWorker.h
+//  PixiAnimate.mp
+//
+
+#ifndef PUBLISH_WORKER_H_
+#define PUBLISH_WORKER_H_
+
+#include "FCMTypes.h"
+#include "FCMPluginInterface.h"
+#include <string>
+
+/* -------------------------------------------------- Macros / Constants */
+
+#define NO_SOCKET ((size_t)-1)
+
+/* -------------------------------------------------- Class Decl */
+
+namespace PixiJS
+{
+	// Long-lived Node process running the publish step, so that publishes
+	// after the first don't pay for starting Node and loading the compiler
+	class PublishWorker
+	{
+	public:
+
+		PublishWorker(FCM::PIFCMCallback pCallback);
+
+		~PublishWorker();
+
+		// Compile a data file, starting or restarting the worker as needed.
+		// Fails without publishing if the worker can't be reached, compiled
+		// is false if the compiler ran and reported an error.
+		FCM::Result Publish(const std::string& dataFile, bool debug, bool& compiled);
+
+		// Open a job the output data is streamed into while it's exported
+		bool BeginStream(const std::string& dataFile, bool debug);
+
+		// Send a serialized item of a section
+		bool StreamFragment(const std::string& section, const std::string& content);
+
+		// Send the _meta trailer and wait for the worker to compile the job.
+		// Fails without publishing if any part of the stream was lost.
+		FCM::Result EndStream(const std::string& meta, bool& compiled);
+
+		// Drop the streamed job without publishing it
+		void CancelStream();
+
+		// Ask the worker process to exit
+		void Stop();
+
+	private:
+
+		// Launch the worker and wait for it to answer
+		bool Start();
+
+		// Health check, true if the worker answers
+		bool Ping();
+
+		// Send one request line and read one response line, waiting at
+		// most timeoutMs for it
+		bool Send(const std::string& request, std::string& response, int timeoutMs);
+
+		// Open a connection to the worker, NO_SOCKET on failure
+		size_t Connect();
+
+		bool SendAll(size_t sock, const std::string& data);
+
+		// Read one response line and close the connection
+		bool Receive(size_t sock, std::string& response, int timeoutMs);
+
+		// Set a send or receive timeout on a connection
+		void SetTimeout(size_t sock, int option, int timeoutMs);
+
+		// Stop using the worker if a job failed because it stopped answering
+		void OnJobFailed();
+
+		// Send a length-prefixed frame on the stream
+		bool SendFrame(const std::string& header, const std::string& content);
+
+		void CloseStream();
+
+		bool ReadPort();
+
+		std::string Request(const std::string& command);
+
+		FCM::PIFCMCallback m_pCallback;
+
+		// Written by the worker once it is listening
+		std::string m_portFile;
+
+		// Passes the token to a new worker, which deletes it once read
+		std::string m_tokenFile;
+
+		// Requests without it are ignored by the worker
+		std::string m_token;
+
+		int m_port;
+
+		bool m_socketsReady;
+
+		// Set once a job times out, the worker isn't used again
+		bool m_hung;
+
+		// If the last receive ended on its timeout
+		bool m_timedOut;
+
+		// Connection of the job being streamed, sockets are held as size_t
+		// to fit both platforms, NO_SOCKET when there is none
+		size_t m_streamSocket;
+
+		// Set once a frame of the stream fails to send
+		bool m_streamFailed;
+	};
+};
+
+#endif // PUBLISH_WORKER_H_
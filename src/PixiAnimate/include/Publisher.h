@@ -26,6 +26,8 @@
 #define PUBLISHER_H_
 
 #include <vector>
+#include <set>
+#include <memory>
 
 #include "Version.h"
 #include "FCMTypes.h"
@@ -40,8 +42,14 @@
 #include "FrameElement/IClassicText.h"
 #include "FrameElement/ITextStyle.h"
 #include "Exporter/Service/IFrameCommandGenerator.h"
+#include "Service/Tween/IGeometricTweener.h"
+#include "Service/Tween/IColorTweener.h"
+#include "Service/Shape/IRegionGeneratorService.h"
+#include "Service/Shape/IShapeService.h"
 #include "OutputWriter.h"
 #include "TimelineWriter.h"
+#include "PublishWorker.h"
+#include "ResourceIdSet.h"
 #include "PluginConfiguration.h"
 
  /* -------------------------------------------------- Forward Decl */
@@ -145,12 +153,39 @@ namespace PixiJS
 
 		FCM::Result ExportLibraryItems(FCM::FCMListPtr pLibraryItemList);
 
+		// Hand the keyframe tweens of the stage and symbols to the output writer
+		FCM::Result ExportTweenSpans(
+			DOM::PIFLADocument flaDocument,
+			DOM::PITimeline timeline,
+			OutputWriter* pOutputWriter);
+
+		FCM::Result ExportLibraryTweenSpans(
+			FCM::FCMListPtr pLibraryItemList,
+			OutputWriter* pOutputWriter);
+
+		void GetTweenSpans(DOM::PITimeline timeline, TWEEN_SPAN_LIST& spans);
+
+		void GetLayerTweenSpans(FCM::FCMListPtr pLayerList, TWEEN_SPAN_LIST& spans);
+
 		FCM::Result CopyRuntime(const std::string& outputFolder, const bool& compressJS);
 
 	private:
 
 		AutoPtr<IFrameCommandGenerator> m_frameCmdGeneratorService;
 		AutoPtr<IResourcePalette> m_pResourcePalette;
+
+		// Output of the last publish, for clearing its cache files
+		std::string m_basePath;
+		std::string m_outputFile;
+
+		// Started by the first publish, kept for the life of the plugin
+		std::auto_ptr<PublishWorker> m_publishWorker;
+
+		// Electron is only looked for once per session
+		bool m_electronChecked;
+
+		AutoPtr<DOM::Service::Tween::IGeometricTweener> m_geometricTweener;
+		AutoPtr<DOM::Service::Tween::IColorTweener> m_colorTweener;
 	};
 
 
@@ -191,10 +226,17 @@ namespace PixiJS
 
 		~ResourcePalette();
 
-		void Init(IOutputWriter* outputWriter);
+		// pathTolerance is how far in pixels a simplified path may stray, 0 for none
+		void Init(IOutputWriter* outputWriter, double pathTolerance);
 
 		void Clear();
 
+		// Fetch the shape services, once for the life of the plugin
+		FCM::Result InitServices();
+
+		// Report the shape export timings and the path points before and after simplification
+		void TraceStats();
+
 		FCM::Result HasResource(
 			const std::string& name,
 			FCM::Boolean& hasResource);
@@ -203,7 +245,9 @@ namespace PixiJS
 
 		FCM::Result ExportFill(DOM::FrameElement::PIShape pIShape);
 
-		FCM::Result ExportStroke(DOM::FrameElement::PIShape pIShape);
+		FCM::Result ExportFill(FCM::FCMListPtr pFilledRegionList);
+
+		FCM::Result ExportStroke(FCM::FCMListPtr pStrokeGroupList);
 
 		FCM::Result ExportStrokeStyle(FCM::PIFCMUnknown pStrokeStyle);
 
@@ -217,6 +261,12 @@ namespace PixiJS
 
 		FCM::Result ExportPath(DOM::Service::Shape::PIPath pPath);
 
+		// Fold flat curves into lines and thin out runs of lines, within m_pathTolerance
+		void SimplifyPath(std::vector<DOM::Utils::SEGMENT>& segments);
+
+		// Append the pending run of points to m_simplified as lines, thinned
+		void FlushLineRun();
+
 		FCM::Result ExportSolidFillStyle(
 			DOM::FillStyle::ISolidFillStyle* pSolidFillStyle);
 
@@ -231,7 +281,7 @@ namespace PixiJS
 
 		FCM::Result GetTextStyle(DOM::FrameElement::ITextStyle* pTextStyleItem, TEXT_STYLE& textStyle);
 
-		FCM::Result HasFancyStrokes(DOM::FrameElement::PIShape pShape, FCM::Boolean& hasFancy);
+		FCM::Result HasFancyStrokes(FCM::FCMListPtr pStrokeGroupList, FCM::Boolean& hasFancy);
 
 		FCM::Result ConvertStrokeToFill(
 			DOM::FrameElement::PIShape pShape,
@@ -239,13 +289,51 @@ namespace PixiJS
 
 		FCM::Result GetTextBehaviour(DOM::FrameElement::ITextBehaviour* pTextBehaviour, TEXT_BEHAVIOUR& textBehaviour);
 
+		void AddResource(FCM::U_Int32 resourceId);
+
+		void AddResourceName(const std::string& name);
+
 	private:
 
 		IOutputWriter* m_outputWriter;
 
-		std::vector<FCM::U_Int32> m_resourceList;
+		AutoPtr<DOM::Service::Shape::IRegionGeneratorService> m_regionGeneratorService;
+
+		AutoPtr<DOM::Service::Shape::IShapeService> m_shapeService;
+
+		// Time spent on shapes, in total and in the region generator and stroke conversion
+		FCM::U_Int32 m_shapeCount;
+
+		FCM::U_Int32 m_regionCalls;
+
+		FCM::Double m_shapeTime;
+
+		FCM::Double m_regionTime;
+
+		FCM::Double m_convertTime;
+
+		double m_pathTolerance;
+
+		// Segments of the path being exported, reused between paths
+		std::vector<DOM::Utils::SEGMENT> m_segments;
+
+		std::vector<DOM::Utils::SEGMENT> m_simplified;
+
+		std::vector<DOM::Utils::POINT2D> m_runPoints;
+
+		std::vector<bool> m_keepPoints;
+
+		// Largest deviation of a curve flattened into the current run
+		double m_runSlack;
+
+		// Points of the exported paths, as written to the path data
+		FCM::U_Int32 m_pathPointsIn;
+
+		FCM::U_Int32 m_pathPointsOut;
+
+		ResourceIdSet m_resourceIds;
 
-		std::vector<std::string> m_resourceNames;
+		std::set<std::string> m_resourceNames;
 	};
 
 
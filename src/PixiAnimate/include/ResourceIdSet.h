@@ -0,0 +1,45 @@
+//
+//  ResourceIdSet.h
+//  PixiAnimate.mp
+//
+
+#ifndef RESOURCE_ID_SET_H_
+#define RESOURCE_ID_SET_H_
+
+#include "FCMTypes.h"
+#include <set>
+#include <vector>
+
+/* -------------------------------------------------- Class Decl */
+
+namespace PixiJS
+{
+	// Ids of the resources already exported. They are small and sequential,
+	// so ids below MAX_DIRECT_ID are a bit each, indexed directly. Larger
+	// ones go in a set rather than growing the bits to match.
+	class ResourceIdSet
+	{
+	public:
+
+		ResourceIdSet();
+
+		~ResourceIdSet();
+
+		void Insert(FCM::U_Int32 id);
+
+		bool Contains(FCM::U_Int32 id) const;
+
+		void Clear();
+
+		// 128KB of bits at most
+		static const FCM::U_Int32 MAX_DIRECT_ID = 1 << 20;
+
+	private:
+
+		std::vector<bool> m_direct;
+
+		std::set<FCM::U_Int32> m_sparse;
+	};
+};
+
+#endif // RESOURCE_ID_SET_H_
@@ -12,6 +12,7 @@
 #include "IOutputWriter.h"
 #include "Utils.h"
 #include <vector>
+#include <map>
 
 class JSONNode;
 
@@ -82,17 +83,84 @@ namespace PixiJS
 
 		virtual FCM::Result SetFrameLabel(FCM::StringRep16 pLabel, DOM::KeyFrameLabelType labelType);
 
-		TimelineWriter(FCM::PIFCMCallback pCallback);
+		// Positions are written to positionPrecision decimal places. With
+		// animationTracks, display properties are written as per-instance
+		// tracks instead of Move, ColorTransform and Visibility commands.
+		TimelineWriter(FCM::PIFCMCallback pCallback, int positionPrecision, bool animationTracks);
 
 		virtual ~TimelineWriter();
 
 		const JSONNode* GetRoot();
 
-		void Finish(FCM::U_Int32 resId, FCM::StringRep16 pName, std::string name);
+		// Tolerance is in pixels, negative writes every transform as a Move.
+		// Keyframe tweens read from the DOM, if any, set where tweens split.
+		void Finish(
+			FCM::U_Int32 resId,
+			FCM::StringRep16 pName,
+			std::string name,
+			double tweenTolerance,
+			const TWEEN_SPAN_LIST* pTweenSpans = NULL);
 
 
 	private:
 
+		// A transform an instance had on a frame, kept until Finish to
+		// be fitted into tweens
+		struct TRANSFORM_KEY
+		{
+			FCM::U_Int32 frame;
+			DOM::Utils::MATRIX2D matrix;
+
+			// Already in the output, so it needs no Move of its own
+			bool written;
+		};
+
+		struct COLOR_KEY
+		{
+			FCM::U_Int32 frame;
+			DOM::Utils::COLOR_MATRIX matrix;
+		};
+
+		typedef std::vector<TRANSFORM_KEY> TransformTrack;
+
+		typedef std::vector<COLOR_KEY> ColorTrack;
+
+		// First and last frame of a keyframe tween an instance plays
+		typedef std::vector<std::pair<FCM::U_Int32, FCM::U_Int32> > FrameSpans;
+
+		void AddTransformKey(
+			FCM::U_Int32 objectId,
+			const DOM::Utils::MATRIX2D& matrix,
+			bool written);
+
+		// Find the instance each keyframe tween belongs to
+		void MatchTweenSpans(const TWEEN_SPAN_LIST& spans);
+
+		bool IsAlive(FCM::U_Int32 objectId, FCM::U_Int32 frame);
+
+		// Key in effect on a frame, NULL if the instance isn't on stage
+		const TRANSFORM_KEY* HeldTransform(FCM::U_Int32 objectId, FCM::U_Int32 frame);
+
+		DOM::Utils::COLOR_MATRIX HeldColor(FCM::U_Int32 objectId, FCM::U_Int32 frame);
+
+		// Write the transforms and colors, collapsing runs of them into tweens
+		void WriteTweenTracks(double tolerance);
+
+		// Collapse a run of consecutive transforms into Tween and Move commands
+		void WriteTransformRun(
+			FCM::U_Int32 objectId,
+			const TransformTrack& run,
+			double tolerance,
+			std::map<FCM::U_Int32, JSONNode*>& frameCommands);
+
+		// Write ColorTween commands for the color tweens matched to an
+		// instance, and ColorTransform commands for the rest
+		void WriteColorTracks(std::map<FCM::U_Int32, JSONNode*>& frameCommands);
+
+		// Write each instance's display properties as a track per property,
+		// each a list of frame deltas and the values that changed on them
+		void WriteAnimationTracks();
+
 		FCM::Result DeferUpdateMasks();
 
 		FCM::Result DeferUpdateMask(
@@ -108,16 +176,36 @@ namespace PixiJS
 
 		JSONNode* m_pTimelineElement;
 
-		JSONNode* m_pFrameElement;
-
 		JSONNode* m_pLabelElement;
 
 		JSONNode* m_pFrameScripts;
 
+		JSONNode* m_pTrackArray;
+
 		std::vector<MaskInfo> maskInfoList;
 
+		std::map<FCM::U_Int32, TransformTrack> m_transformTracks;
+
+		std::map<FCM::U_Int32, ColorTrack> m_colorTracks;
+
+		// Frame each instance was removed on
+		std::map<FCM::U_Int32, FCM::U_Int32> m_removeFrames;
+
+		// Keyframe tweens matched to each instance
+		std::map<FCM::U_Int32, FrameSpans> m_transformSpans;
+
+		std::map<FCM::U_Int32, FrameSpans> m_colorSpans;
+
+		// Frames each instance's visibility changed on, for the animation tracks
+		std::map<FCM::U_Int32, std::vector<std::pair<FCM::U_Int32, bool> > > m_visibilityTracks;
+
+		bool m_animationTracks;
+
 		FCM::PIFCMCallback m_pCallback;
 
+		// Multiplier positions are rounded to whole steps of
+		double m_positionQuantum;
+
 		FCM::U_Int32 m_FrameCount;
 	};
 };
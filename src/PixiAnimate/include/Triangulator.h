@@ -0,0 +1,112 @@
+//
+//  Triangulator.h
+//  PixiAnimate.mp
+//
+
+#ifndef TRIANGULATOR_H_
+#define TRIANGULATOR_H_
+
+#include "FCMTypes.h"
+#include <cstddef>
+#include <deque>
+#include <vector>
+
+/* -------------------------------------------------- Class Decl */
+
+namespace PixiJS
+{
+	// Ear clipping triangulation of a polygon with holes, a port of mapbox's
+	// earcut. Holes are joined to the outline by bridges, and large polygons
+	// look up the points inside a candidate ear with a z-order curve.
+	class Triangulator
+	{
+	public:
+
+		Triangulator();
+
+		~Triangulator();
+
+		// Triangulate coords, x and y pairs of the outline followed by the holes.
+		// holes has the vertex each hole starts at. Appends three vertex
+		// indices per triangle, returns false if nothing could be triangulated.
+		bool Triangulate(
+			const std::vector<FCM::Double>& coords,
+			const std::vector<FCM::U_Int32>& holes,
+			std::vector<FCM::U_Int32>& triangles);
+
+		// Vertex of a ring, public for the geometry helpers
+		struct Node
+		{
+			// Vertex in the coords
+			FCM::U_Int32 i;
+
+			FCM::Double x;
+
+			FCM::Double y;
+
+			// Position on the z-order curve
+			FCM::S_Int32 z;
+
+			// Vertices of the ring
+			Node* prev;
+
+			Node* next;
+
+			// Nodes sorted by z
+			Node* prevZ;
+
+			Node* nextZ;
+
+			// Bridge point of a single vertex hole
+			bool steiner;
+		};
+
+	private:
+
+		Node* LinkedList(const std::vector<FCM::Double>& coords, size_t start, size_t end, bool clockwise);
+
+		Node* FilterPoints(Node* start, Node* end);
+
+		void EarcutLinked(Node* ear, int pass);
+
+		bool IsEar(Node* ear);
+
+		bool IsEarHashed(Node* ear);
+
+		Node* CureLocalIntersections(Node* start);
+
+		void SplitEarcut(Node* start);
+
+		Node* EliminateHoles(const std::vector<FCM::Double>& coords, const std::vector<FCM::U_Int32>& holes, Node* outerNode);
+
+		Node* EliminateHole(Node* hole, Node* outerNode);
+
+		Node* FindHoleBridge(Node* hole, Node* outerNode);
+
+		void IndexCurve(Node* start);
+
+		Node* SortLinked(Node* list);
+
+		FCM::S_Int32 ZOrder(FCM::Double x, FCM::Double y);
+
+		Node* SplitPolygon(Node* a, Node* b);
+
+		Node* InsertNode(FCM::U_Int32 i, FCM::Double x, FCM::Double y, Node* last);
+
+		void AddTriangle(Node* a, Node* b, Node* c);
+
+		// Nodes of the current polygon, a deque so they never move
+		std::deque<Node> m_nodes;
+
+		std::vector<FCM::U_Int32>* m_pTriangles;
+
+		// Bounds and scale of the z-order curve, m_invSize is 0 when not hashing
+		FCM::Double m_minX;
+
+		FCM::Double m_minY;
+
+		FCM::Double m_invSize;
+	};
+};
+
+#endif // TRIANGULATOR_H_
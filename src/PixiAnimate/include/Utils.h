@@ -30,6 +30,7 @@
 #include "Utils/DOMTypes.h"
 #include "JSONNode.h"
 #include <string>
+#include <vector>
 #include "FillStyle/IGradientFillStyle.h"
 #include "FrameElement/IClassicText.h"
 #include "FrameElement/IParagraph.h"
@@ -55,6 +56,16 @@ namespace PixiJS
 		INVALID_STROKE_STYLE_TYPE,
 		SOLID_STROKE_STYLE_TYPE
 	};
+
+	// How user text is escaped before it goes in the output
+	enum EscapeMode
+	{
+		// Frame script code, line breaks become \n and tabs are dropped
+		ESCAPE_SCRIPT,
+
+		// Content of a JS string literal, also escapes backslashes and U+2028/2029
+		ESCAPE_TEXT
+	};
 }
 
 /* -------------------------------------------------- Structs / Unions */
@@ -85,6 +96,18 @@ namespace PixiJS
 		FCM::U_Int32 objectId;
 		FCM::U_Int32 maskTillObjectId;
 	};
+
+	// A keyframe tween read from the DOM, with the transform and color on
+	// its first frames to find the instance it belongs to
+	struct TWEEN_SPAN
+	{
+		FCM::U_Int32 frame;
+		FCM::U_Int32 duration;
+		std::vector<DOM::Utils::MATRIX2D> matrices;
+		std::vector<DOM::Utils::COLOR_MATRIX> colors;
+	};
+
+	typedef std::vector<TWEEN_SPAN> TWEEN_SPAN_LIST;
 }
 
 /* -------------------------------------------------- Macros / Constants */
@@ -140,6 +163,13 @@ namespace PixiJS
 #define DICT_IMAGES           "PublishSettings.PixiJS.Images"
 #define DICT_SOUNDS           "PublishSettings.PixiJS.Sounds"
 #define DICT_LOOP_TIMELINE    "PublishSettings.PixiJS.LoopTimeline"
+#define DICT_TWEEN_TOLERANCE  "PublishSettings.PixiJS.TweenTolerance"
+#define DICT_NATIVE_TWEENS    "PublishSettings.PixiJS.NativeTweens"
+#define DICT_TRANSFORM_PRECISION "PublishSettings.PixiJS.TransformPrecision"
+#define DICT_ANIMATION_TRACKS "PublishSettings.PixiJS.AnimationTracks"
+#define DICT_TRIANGULATE_FILLS "PublishSettings.PixiJS.TriangulateFills"
+#define DICT_PATH_TOLERANCE   "PublishSettings.PixiJS.PathTolerance"
+#define DICT_REUSE_IMAGES     "PublishSettings.PixiJS.ReuseImages"
 
 /* -------------------------------------------------- Structs / Unions */
 
@@ -241,6 +271,9 @@ namespace PixiJS
 
 		static bool Exists(const std::string& fileName);
 
+		// Last write time of a file in seconds, false if it can't be read
+		static bool GetModifiedTime(const std::string& fileName, FCM::U_Int64& time);
+
 		static void OpenFStream(
 			const std::string& outputFile,
 			std::fstream &file,
@@ -286,8 +319,18 @@ namespace PixiJS
 			const std::string &from,
 			const std::string &to);
 
+		// Escape in a single pass, returns the content as is if nothing needs it
+		static std::string Escape(const std::string &content, EscapeMode mode);
+
+		static FCM::U_Int64 Hash(const std::string &content);
+
 		static int RunElectron(std::string argline);
 
+		static int RunNode(std::string argline);
+
+		// Start Node without waiting for it to exit
+		static bool LaunchNode(std::string argline);
+
 
 #ifdef USE_HTTP_SERVER
 
@@ -302,6 +345,11 @@ namespace PixiJS
 
 		static void RemoveTrailingZeroes(char *str);
 
+	private:
+
+		// Run a command line, returns the exit code if waiting for it to exit
+		static int Run(const std::string& cmd, bool wait);
+
 	};
 };
 
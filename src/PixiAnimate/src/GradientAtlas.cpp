@@ -0,0 +1,338 @@
+//
+//  GradientAtlas.cpp
+//  PixiAnimate.mp
+//
+
+#include "GradientAtlas.h"
+#include "Utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace PixiJS
+{
+	static const FCM::U_Int32 ATLAS_WIDTH = 256;
+
+	static const FCM::U_Int32 MAX_ATLAS_HEIGHT = 2048;
+
+	// Left empty between tiles, so filtering never reaches a neighbour
+	static const FCM::U_Int32 TILE_GUTTER = 1;
+
+	// Stored deflate blocks hold at most this many bytes
+	static const FCM::U_Int32 MAX_STORED_BLOCK = 65535;
+
+	const FCM::U_Int32 GradientAtlas::MAX_RAMP_WIDTH;
+
+	const FCM::U_Int32 GradientAtlas::MAX_TILE_SIZE;
+
+	static FCM::U_Int32 Crc32(const std::string& bytes, size_t start)
+	{
+		static FCM::U_Int32 table[256];
+		static bool tableReady = false;
+		if (!tableReady)
+		{
+			for (FCM::U_Int32 n = 0; n < 256; n++)
+			{
+				FCM::U_Int32 c = n;
+				for (int k = 0; k < 8; k++)
+				{
+					c = (c & 1) ? 0xEDB88320 ^ (c >> 1) : c >> 1;
+				}
+				table[n] = c;
+			}
+			tableReady = true;
+		}
+
+		FCM::U_Int32 crc = 0xFFFFFFFF;
+		for (size_t i = start; i < bytes.size(); i++)
+		{
+			crc = table[(crc ^ (unsigned char)bytes[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return crc ^ 0xFFFFFFFF;
+	}
+
+	static void AppendUInt32BE(std::string& bytes, FCM::U_Int32 value)
+	{
+		bytes.push_back((char)((value >> 24) & 0xFF));
+		bytes.push_back((char)((value >> 16) & 0xFF));
+		bytes.push_back((char)((value >> 8) & 0xFF));
+		bytes.push_back((char)(value & 0xFF));
+	}
+
+	static void AppendChunk(std::string& png, const char* type, const std::string& data)
+	{
+		AppendUInt32BE(png, (FCM::U_Int32)data.size());
+		size_t start = png.size();
+		png.append(type, 4);
+		png.append(data);
+		AppendUInt32BE(png, Crc32(png, start));
+	}
+
+	GradientAtlas::GradientAtlas()
+	{
+		Clear();
+	}
+
+	GradientAtlas::~GradientAtlas()
+	{
+	}
+
+	void GradientAtlas::Clear()
+	{
+		m_pixels.clear();
+		m_tiles.clear();
+		m_shelfX = 0;
+		m_shelfY = 0;
+		m_shelfHeight = 0;
+	}
+
+	bool GradientAtlas::AddLinearRamp(
+		const std::vector<DOM::Utils::GRADIENT_COLOR_POINT>& stops,
+		DOM::FillStyle::GradientSpread spread,
+		FCM::Double t0,
+		FCM::Double t1,
+		FCM::U_Int32 width,
+		FCM::U_Int32& x,
+		FCM::U_Int32& y)
+	{
+		if (stops.empty() || width == 0 || width > MAX_RAMP_WIDTH)
+		{
+			return false;
+		}
+
+		m_tile.resize(width * 4);
+		for (FCM::U_Int32 i = 0; i < width; i++)
+		{
+			FCM::Double t = width > 1 ? t0 + (t1 - t0) * i / (width - 1) : t0;
+			Sample(stops, spread, t, &m_tile[i * 4]);
+		}
+		return Place(width, 1, x, y);
+	}
+
+	bool GradientAtlas::AddRadialTile(
+		const std::vector<DOM::Utils::GRADIENT_COLOR_POINT>& stops,
+		DOM::FillStyle::GradientSpread spread,
+		FCM::Double focal,
+		FCM::Double x0,
+		FCM::Double y0,
+		FCM::Double x1,
+		FCM::Double y1,
+		FCM::U_Int32 width,
+		FCM::U_Int32 height,
+		FCM::U_Int32& x,
+		FCM::U_Int32& y)
+	{
+		if (stops.empty() || width == 0 || height == 0 ||
+			width > MAX_TILE_SIZE || height > MAX_TILE_SIZE)
+		{
+			return false;
+		}
+
+		// Flash keeps the focal point inside the circle
+		focal = focal < -0.99 ? -0.99 : (focal > 0.99 ? 0.99 : focal);
+
+		m_tile.resize(width * height * 4);
+		for (FCM::U_Int32 j = 0; j < height; j++)
+		{
+			FCM::Double py = height > 1 ? y0 + (y1 - y0) * j / (height - 1) : y0;
+			for (FCM::U_Int32 i = 0; i < width; i++)
+			{
+				FCM::Double px = width > 1 ? x0 + (x1 - x0) * i / (width - 1) : x0;
+
+				// t is how far the point is from the focal point, over the
+				// distance from the focal point to the circle in that direction
+				FCM::Double dx = px - focal;
+				FCM::Double dy = py;
+				FCM::Double distance = sqrt(dx * dx + dy * dy);
+				FCM::Double t = 0;
+				if (distance > 0)
+				{
+					FCM::Double dot = focal * dx / distance;
+					FCM::Double reach = -dot + sqrt(dot * dot - focal * focal + 1.0);
+					t = distance / reach;
+				}
+				Sample(stops, spread, t, &m_tile[(j * width + i) * 4]);
+			}
+		}
+		return Place(width, height, x, y);
+	}
+
+	bool GradientAtlas::IsEmpty() const
+	{
+		return m_tiles.empty();
+	}
+
+	FCM::U_Int32 GradientAtlas::GetWidth() const
+	{
+		return ATLAS_WIDTH;
+	}
+
+	FCM::U_Int32 GradientAtlas::GetHeight() const
+	{
+		return (FCM::U_Int32)(m_pixels.size() / (ATLAS_WIDTH * 4));
+	}
+
+	bool GradientAtlas::Place(FCM::U_Int32 width, FCM::U_Int32 height, FCM::U_Int32& x, FCM::U_Int32& y)
+	{
+		std::string bytes((const char*)&m_tile[0], m_tile.size());
+		std::pair<FCM::U_Int64, FCM::U_Int32> key(Utils::Hash(bytes), (width << 16) | height);
+
+		std::map<std::pair<FCM::U_Int64, FCM::U_Int32>, std::pair<FCM::U_Int32, FCM::U_Int32> >::iterator it =
+			m_tiles.find(key);
+		if (it != m_tiles.end())
+		{
+			x = it->second.first;
+			y = it->second.second;
+			return true;
+		}
+
+		// Start a new shelf when the tile doesn't fit on the end of this one
+		if (m_shelfX + width > ATLAS_WIDTH)
+		{
+			m_shelfY += m_shelfHeight + TILE_GUTTER;
+			m_shelfX = 0;
+			m_shelfHeight = 0;
+		}
+		if (m_shelfY + height > MAX_ATLAS_HEIGHT)
+		{
+			return false;
+		}
+
+		x = m_shelfX;
+		y = m_shelfY;
+
+		if (m_pixels.size() < (size_t)(y + height) * ATLAS_WIDTH * 4)
+		{
+			m_pixels.resize((size_t)(y + height) * ATLAS_WIDTH * 4, 0);
+		}
+		for (FCM::U_Int32 row = 0; row < height; row++)
+		{
+			memcpy(&m_pixels[((size_t)(y + row) * ATLAS_WIDTH + x) * 4],
+				&m_tile[(size_t)row * width * 4], width * 4);
+		}
+
+		m_shelfX += width + TILE_GUTTER;
+		m_shelfHeight = height > m_shelfHeight ? height : m_shelfHeight;
+		m_tiles.insert(std::make_pair(key, std::make_pair(x, y)));
+
+		return true;
+	}
+
+	void GradientAtlas::Sample(
+		const std::vector<DOM::Utils::GRADIENT_COLOR_POINT>& stops,
+		DOM::FillStyle::GradientSpread spread,
+		FCM::Double t,
+		FCM::Byte* pixel)
+	{
+		if (spread == DOM::FillStyle::GRADIENT_SPREAD_REPEAT)
+		{
+			t -= floor(t);
+		}
+		else if (spread == DOM::FillStyle::GRADIENT_SPREAD_REFLECT)
+		{
+			t = fabs(t - 2.0 * floor(t * 0.5 + 0.5));
+		}
+		t = t < 0 ? 0 : (t > 1 ? 1 : t);
+
+		// Stop positions are 0 to 255, in order
+		FCM::Double pos = t * 255.0;
+		size_t next = 0;
+		while (next < stops.size() && stops[next].pos < pos)
+		{
+			next++;
+		}
+
+		const DOM::Utils::COLOR* from;
+		const DOM::Utils::COLOR* to;
+		FCM::Double mix = 0;
+		if (next == 0)
+		{
+			from = to = &stops[0].color;
+		}
+		else if (next == stops.size())
+		{
+			from = to = &stops[next - 1].color;
+		}
+		else
+		{
+			from = &stops[next - 1].color;
+			to = &stops[next].color;
+			FCM::Double span = (FCM::Double)stops[next].pos - stops[next - 1].pos;
+			mix = span > 0 ? (pos - stops[next - 1].pos) / span : 1.0;
+		}
+
+		pixel[0] = (FCM::Byte)(from->red + (to->red - from->red) * mix + 0.5);
+		pixel[1] = (FCM::Byte)(from->green + (to->green - from->green) * mix + 0.5);
+		pixel[2] = (FCM::Byte)(from->blue + (to->blue - from->blue) * mix + 0.5);
+		pixel[3] = (FCM::Byte)(from->alpha + (to->alpha - from->alpha) * mix + 0.5);
+	}
+
+	bool GradientAtlas::Save(const std::string& path) const
+	{
+		FCM::U_Int32 height = GetHeight();
+		if (height == 0)
+		{
+			return false;
+		}
+
+		// Filter type 0 before every row
+		std::string raw;
+		raw.reserve((size_t)height * (ATLAS_WIDTH * 4 + 1));
+		for (FCM::U_Int32 row = 0; row < height; row++)
+		{
+			raw.push_back(0);
+			raw.append((const char*)&m_pixels[(size_t)row * ATLAS_WIDTH * 4], ATLAS_WIDTH * 4);
+		}
+
+		// A zlib stream of stored blocks, ramps are small enough not to need compressing
+		std::string idat;
+		idat.push_back((char)0x78);
+		idat.push_back((char)0x01);
+		size_t offset = 0;
+		do
+		{
+			FCM::U_Int32 length = (FCM::U_Int32)std::min<size_t>(raw.size() - offset, MAX_STORED_BLOCK);
+			bool last = offset + length == raw.size();
+			idat.push_back(last ? 1 : 0);
+			idat.push_back((char)(length & 0xFF));
+			idat.push_back((char)(length >> 8));
+			idat.push_back((char)(~length & 0xFF));
+			idat.push_back((char)((~length >> 8) & 0xFF));
+			idat.append(raw, offset, length);
+			offset += length;
+		} while (offset < raw.size());
+
+		FCM::U_Int32 a = 1;
+		FCM::U_Int32 b = 0;
+		for (size_t i = 0; i < raw.size(); i++)
+		{
+			a = (a + (unsigned char)raw[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+		AppendUInt32BE(idat, (b << 16) | a);
+
+		std::string header;
+		AppendUInt32BE(header, ATLAS_WIDTH);
+		AppendUInt32BE(header, height);
+		header.push_back(8); // Bit depth
+		header.push_back(6); // RGBA
+		header.push_back(0);
+		header.push_back(0);
+		header.push_back(0);
+
+		std::string png("\x89PNG\r\n\x1A\n", 8);
+		AppendChunk(png, "IHDR", header);
+		AppendChunk(png, "IDAT", idat);
+		AppendChunk(png, "IEND", std::string());
+
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+		{
+			return false;
+		}
+		file.write(png.data(), png.size());
+		return file.good();
+	}
+};
@@ -36,6 +36,8 @@
 #include <sstream>
 #include <string>
 #include <iterator>
+#include <cstdio>
+#include <ctime>
 
 #include "FlashFCMPublicIDs.h"
 #include "FCMPluginInterface.h"
@@ -56,6 +58,7 @@
 #include "Utils/ILinearColorGradient.h"
 #include <math.h>
 #include "TimelineWriter.h"
+#include "PublishWorker.h"
 
 #ifdef _WINDOWS
 #include <experimental\filesystem>
@@ -65,19 +68,118 @@ namespace fs = std::experimental::filesystem;
 
 namespace PixiJS
 {
-	// Keys for render to graphics
-	static const std::string moveTo = "m";
-	static const std::string lineTo = "l";
-	static const std::string quadraticCurveTo = "q";
-	static const std::string closePath = "c";
-	static const std::string addHole = "h";
+	// Opcodes of the packed path data, decoded by DataUtils.decodePath
+	static const unsigned char moveTo = 0;
+	static const unsigned char lineTo = 1;
+	static const unsigned char quadraticCurveTo = 2;
+	static const unsigned char closePath = 3;
+	static const unsigned char addHole = 4;
+
+	// Path coordinates are packed as integer hundredths of a pixel
+	static const FCM::Double PATH_PRECISION = 100.0;
+
+	// Pixels a flattened curve may stray from the real one in a fill mesh
+	static const FCM::Double MESH_TOLERANCE = 0.1;
+
+	static const int MAX_CURVE_STEPS = 64;
+
+	// Mesh indices are 16-bit, so WebGL 1 can draw them without extensions
+	static const size_t MAX_MESH_VERTICES = 65536;
+
+	// Pixels of a fill covered by one texel of its baked radial gradient
+	static const FCM::Double RADIAL_TEXEL_SIZE = 2.0;
+
+	// Little-endian bytes of a float, as a Float32Array reads them
+	static void AppendFloat32(std::string& bytes, float value)
+	{
+		FCM::U_Int32 bits;
+		memcpy(&bits, &value, sizeof(bits));
+		for (int i = 0; i < 4; i++)
+		{
+			bytes.push_back((char)(bits & 0xFF));
+			bits >>= 8;
+		}
+	}
+
+	// Little-endian bytes of an index, as a Uint16Array reads them
+	static void AppendUInt16(std::string& bytes, FCM::U_Int32 value)
+	{
+		bytes.push_back((char)(value & 0xFF));
+		bytes.push_back((char)((value >> 8) & 0xFF));
+	}
+
+	// Inverse of an affine matrix, false if it squashes everything onto a line
+	static bool InvertMatrix(const DOM::Utils::MATRIX2D& matrix, DOM::Utils::MATRIX2D& inverse)
+	{
+		FCM::Double det = (FCM::Double)matrix.a * matrix.d - (FCM::Double)matrix.b * matrix.c;
+		if (det == 0)
+		{
+			return false;
+		}
+		inverse.a = (FCM::Float)(matrix.d / det);
+		inverse.b = (FCM::Float)(-matrix.b / det);
+		inverse.c = (FCM::Float)(-matrix.c / det);
+		inverse.d = (FCM::Float)(matrix.a / det);
+		inverse.tx = (FCM::Float)(((FCM::Double)matrix.c * matrix.ty - (FCM::Double)matrix.d * matrix.tx) / det);
+		inverse.ty = (FCM::Float)(((FCM::Double)matrix.b * matrix.tx - (FCM::Double)matrix.a * matrix.ty) / det);
+		return true;
+	}
 
 	// Template
 	static const std::string html = "index.html";
 	static const std::string htmlDebug = "index-debug.html";
 
+	// A template split at its ${key} placeholders
+	struct ParsedTemplate
+	{
+		FCM::U_Int64 modified;
+
+		// Text around the placeholders, one more run than there are keys
+		std::vector<std::string> text;
+
+		std::vector<std::string> keys;
+	};
+
+	// Parsed templates by path, kept between publishes until the file changes
+	static std::map<std::string, ParsedTemplate> templateCache;
+
+	// Split a template into its text and ${key} placeholders
+	static void ParseTemplate(const std::string& content, ParsedTemplate& parsed)
+	{
+		parsed.text.clear();
+		parsed.keys.clear();
+
+		size_t start = 0;
+		size_t open;
+		while ((open = content.find("${", start)) != std::string::npos)
+		{
+			size_t close = content.find('}', open + 2);
+			if (close == std::string::npos)
+			{
+				break;
+			}
+			parsed.text.push_back(content.substr(start, open - start));
+			parsed.keys.push_back(content.substr(open + 2, close - open - 2));
+			start = close + 1;
+		}
+		parsed.text.push_back(content.substr(start));
+	}
+
 	static const FCM::Float GRADIENT_VECTOR_CONSTANT = 16384.0;
 
+	// Files kept next to the output between publishes
+	static const std::string CACHE_EXTENSION = ".cache";
+	static const std::string IMAGE_MANIFEST_EXTENSION = ".images.cache";
+
+	// Names of the top-level arrays, indexed by OutputSection
+	static const char* sectionNames[] = {
+		"Shapes",
+		"Bitmaps",
+		"Sounds",
+		"Texts",
+		"Timelines"
+	};
+
 	/* -------------------------------------------------- OutputWriter */
 
 	FCM::Result OutputWriter::StartDocument(const DOM::Utils::COLOR& background,
@@ -119,12 +221,6 @@ namespace PixiJS
 
 	FCM::Result OutputWriter::EndDocument()
 	{
-		m_pRootNode->push_back(*m_pShapeArray);
-		m_pRootNode->push_back(*m_pBitmapArray);
-		m_pRootNode->push_back(*m_pSoundArray);
-		m_pRootNode->push_back(*m_pTextArray);
-		m_pRootNode->push_back(*m_pTimelineArray);
-
 		JSONNode meta(JSON_NODE);
 		meta.set_name("_meta");
 		meta.push_back(JSONNode("outputFile", m_outputFile));
@@ -162,26 +258,147 @@ namespace PixiJS
 		std::string patch = Utils::ToString(PIXIJS_PLUGIN_VERSION_MAINTENANCE);
 
 		meta.push_back(JSONNode("version", (major)+"." + (minor)+"." + (patch)));
-		m_pRootNode->push_back(meta);
 
-		// Write the JSON file (overwrite file if it already exists)
+		// Settings which only reach the templates are part of the output too
+		std::map<std::string, std::string>::const_iterator sub;
+		for (sub = m_substitutions.begin(); sub != m_substitutions.end(); sub++)
+		{
+			m_documentHash = (m_documentHash ^ Utils::Hash(sub->first + "=" + sub->second)) * 1099511628211ULL;
+		}
+		m_documentHash = (m_documentHash ^ Utils::Hash(meta.write())) * 1099511628211ULL;
+
+		if (m_images)
+		{
+			Utils::Trace(m_pCallback, "Exported %u images, %u unchanged\n",
+				m_imagesExported, m_imagesSkipped);
+			WriteImageManifest();
+		}
+
+		// Nothing changed since the last publish and its output is still there.
+		// With images the compiler also writes the shapes, meshes and
+		// spritesheets, which the hash doesn't cover, so those always publish.
+		if (!m_images &&
+			m_documentHash == m_cachedDocumentHash &&
+			Utils::Exists(m_basePath + m_outputFile) &&
+			(!m_html || Utils::Exists(m_basePath + m_htmlPath)))
+		{
+			if (m_streaming)
+			{
+				m_streaming = false;
+				m_pPublishWorker->CancelStream();
+			}
+			RemoveSections();
+			Utils::Trace(m_pCallback, "No changes since the last publish, output is up to date\n");
+			return FCM_SUCCESS;
+		}
+
+		// The worker already has the sections, so no data file is needed
+		bool published = false;
+		bool compiled = false;
+		if (m_streaming)
+		{
+			m_streaming = false;
+			published = FCM_SUCCESS_CODE(m_pPublishWorker->EndStream(meta.write(), compiled));
+		}
+
+		if (published)
+		{
+			RemoveSections();
+		}
+		else
+		{
+			// Write the JSON file (overwrite file if it already exists)
+			CloseSections(meta);
+		}
+
+		if (m_shapeAliasCount > 0)
+		{
+			Utils::Trace(m_pCallback, "Reused %u duplicate shapes, saved %u bytes\n",
+				m_shapeAliasCount, m_shapeAliasBytes);
+		}
+
+		if (m_gradientsBaked > 0)
+		{
+			Utils::Trace(m_pCallback, "Baked %u gradient fills into a %ux%u texture\n",
+				m_gradientsBaked, m_gradientAtlas.GetWidth(), m_gradientAtlas.GetHeight());
+		}
+		if (m_bitmapsMeshed > 0)
+		{
+			Utils::Trace(m_pCallback, "Mapped %u bitmap fills onto their meshes\n", m_bitmapsMeshed);
+		}
+		if (m_bitmapsSkipped > 0)
+		{
+			Utils::Trace(m_pCallback, "Warning: %u bitmap fills and strokes are drawn black, "
+				"bitmaps are only drawn for fills with Triangulate Fills on\n",
+				m_bitmapsSkipped);
+		}
+		if (m_gradientsSkipped > 0)
+		{
+			Utils::Trace(m_pCallback, "Warning: %u gradient fills and strokes are drawn with their first color, "
+				"gradients are only baked for fills with Triangulate Fills and Export Images on\n",
+				m_gradientsSkipped);
+		}
+
+		if (m_triangulateFills)
+		{
+			Utils::Trace(m_pCallback, "Triangulated %u fills into %u triangles in %.3fs\n",
+				m_meshCount, m_meshTriangleCount, m_meshTime);
+			if (m_meshSkipped > 0)
+			{
+				Utils::Trace(m_pCallback, "Warning: %u fills have too many vertices for a mesh and are only drawn as paths\n",
+					m_meshSkipped);
+			}
+		}
+
 #ifdef _DEBUG
-	// If we're in DEBUG mode, write the well-formated JSON with whitespace
-		Save(m_outputDataFile, m_pRootNode->write_formatted());
-#else
-	// JSON with no whitespace
-		Save(m_outputDataFile, m_pRootNode->write());
+		Utils::Trace(m_pCallback, "Path data: %u segments, %u bytes, %.3fs in SetSegment\n",
+			m_segmentCount, m_pathBytes, m_segmentTime);
 #endif
 
+		// Packing spritesheets needs a canvas, everything else runs on plain Node
+		bool electron = m_images && m_spritesheets && m_sectionCounts[BITMAPS_SECTION] > 0;
+
 		std::string extensionPath;
 		Utils::GetExtensionPath(extensionPath, m_pCallback);
-		std::string compiler = extensionPath + NODE_COMPILER;
+		std::string compiler = extensionPath + NODE_COMPILER_CLI;
+		if (electron)
+		{
+			compiler = extensionPath + NODE_COMPILER;
+		}
 		std::string publish = "\"" + compiler + "\" --src \"" + m_outputDataFile + "\"";
+		bool debug = false;
 		
 #ifdef _DEBUG
 		publish += " --debug";
+		debug = true;
 #endif
-		Utils::RunElectron(publish);
+		if (published)
+		{
+			// Compiled by the worker from the streamed sections
+		}
+		else if (electron)
+		{
+			compiled = Utils::RunElectron(publish) == 0;
+		}
+		else if (m_pPublishWorker && FCM_SUCCESS_CODE(m_pPublishWorker->Publish(m_outputDataFile, debug, compiled)))
+		{
+			// Compiled by the running worker
+		}
+		else
+		{
+			compiled = Utils::RunNode(publish) == 0;
+		}
+
+		// Only a publish that finished can be skipped next time
+		if (compiled)
+		{
+			WriteCache();
+		}
+		else
+		{
+			std::remove(m_cacheFile.c_str());
+			Utils::Trace(m_pCallback, "ERROR: Failed to publish %s\n", m_outputFile.c_str());
+		}
 
 		// Output the HTML templates
 		if (m_html)
@@ -206,6 +423,24 @@ namespace PixiJS
 	}
 
 
+	int OutputWriter::GetTransformPrecision()
+	{
+		return m_transformPrecision;
+	}
+
+
+	bool OutputWriter::GetAnimationTracks()
+	{
+		return m_animationTracks;
+	}
+
+
+	void OutputWriter::SetTweenSpans(const std::string& timelineName, const TWEEN_SPAN_LIST& spans)
+	{
+		m_tweenSpans[timelineName] = spans;
+	}
+
+
 	FCM::Result OutputWriter::EndDefineTimeline(
 		FCM::U_Int32 resId,
 		FCM::StringRep16 pName,
@@ -214,11 +449,15 @@ namespace PixiJS
 		TimelineWriter* pWriter = static_cast<TimelineWriter*> (pTimelineWriter);
 
 		std::string timelineName(m_stageName);
+		std::string spansName;
+		bool hasSpans = resId == 0;
 		if (resId != 0)
 		{
 			if (pName)
 			{
 				timelineName = Utils::ToString(pName, m_pCallback);
+				spansName = timelineName;
+				hasSpans = true;
 				Utils::GetJavaScriptName(timelineName, timelineName);
 			}
 			else
@@ -229,9 +468,16 @@ namespace PixiJS
 			}
 		}
 
-		pWriter->Finish(resId, pName, timelineName);
+		const TWEEN_SPAN_LIST* pTweenSpans = NULL;
+		std::map<std::string, TWEEN_SPAN_LIST>::const_iterator spans = m_tweenSpans.find(spansName);
+		if (hasSpans && spans != m_tweenSpans.end())
+		{
+			pTweenSpans = &spans->second;
+		}
+
+		pWriter->Finish(resId, pName, timelineName, m_tweenTolerance, pTweenSpans);
 
-		m_pTimelineArray->push_back(*(pWriter->GetRoot()));
+		WriteToSection(TIMELINES_SECTION, *(pWriter->GetRoot()));
 
 		return FCM_SUCCESS;
 	}
@@ -252,10 +498,34 @@ namespace PixiJS
 	// Marks the end of a shape
 	FCM::Result OutputWriter::EndDefineShape(FCM::U_Int32 resId)
 	{
-		m_shapeElem->push_back(JSONNode("assetId", resId));
-		m_shapeElem->push_back(*m_pathArray);
+		std::string paths = m_pathArray->write();
+		FCM::U_Int64 hash = Utils::Hash(paths);
+		std::string assetId = Utils::ToString(resId);
 
-		m_pShapeArray->push_back(*m_shapeElem);
+		// Hashes can collide, only alias a shape whose paths are the same
+		ShapeMap::iterator it = m_shapeMap.lower_bound(hash);
+		while (it != m_shapeMap.end() && it->first == hash && it->second.first != paths)
+		{
+			it++;
+		}
+
+		if (it != m_shapeMap.end() && it->first == hash)
+		{
+			// Identical artwork was already written, point to that resource instead
+			WriteToSection(SHAPES_SECTION, "{\"assetId\":" + assetId +
+				",\"alias\":" + Utils::ToString(it->second.second) + "}");
+
+			m_shapeAliasCount++;
+			m_shapeAliasBytes += (FCM::U_Int32)paths.length();
+		}
+		else
+		{
+			m_shapeMap.insert(std::make_pair(hash, std::make_pair(paths, resId)));
+
+			// Same layout as the shape node, without writing the paths twice
+			WriteToSection(SHAPES_SECTION, "{\"assetId\":" + assetId +
+				",\"paths\":" + paths + "}");
+		}
 
 		delete m_pathArray;
 		delete m_shapeElem;
@@ -270,9 +540,15 @@ namespace PixiJS
 		m_pathElem = new JSONNode(JSON_NODE);
 		ASSERT(m_pathElem);
 
-		m_pathCmdArray = new JSONNode(JSON_ARRAY);
-		ASSERT(m_pathCmdArray);
-		m_pathCmdArray->set_name("d");
+		m_pathData.clear();
+		m_pathX = 0;
+		m_pathY = 0;
+
+		m_meshFill = m_triangulateFills;
+		m_meshCoords.clear();
+		m_meshHoles.clear();
+		m_gradient = false;
+		m_bitmap = false;
 
 		return FCM_SUCCESS;
 	}
@@ -308,9 +584,7 @@ namespace PixiJS
 		bitmapElem.push_back(JSONNode("height", height));
 		bitmapElem.push_back(JSONNode("width", width));
 
-		FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
-
-		FCM::Boolean alreadyExported = GetImageExportFileName(libPathName, name);
+		FCM::Boolean alreadyExported = GetImageExportFileName(libPathName, name, ext);
 		if (!alreadyExported)
 		{
 			if (m_images && !m_imageFolderCreated)
@@ -325,37 +599,22 @@ namespace PixiJS
 			}
 			Utils::GetFileExtension(libPathName, ext);
 			Utils::GetFileNameWithoutExtension(libPathName, name);
-			SetImageExportFileName(libPathName, name);
 
 			if (ext == "")
 			{
 				ext = "png";
 			}
+			SetImageExportFileName(libPathName, name, ext);
 		}
 
 		std::string bitmapExportPath(m_outputImageFolder + name + "." + ext);
 		std::string bitmapRelPath(m_imagesPath + name + "." + ext);
 
-		res = m_pCallback->GetService(DOM::FLA_BITMAP_SERVICE, pUnk.m_Ptr);
-		ASSERT(FCM_SUCCESS_CODE(res));
-
-		FCM::AutoPtr<DOM::Service::Image::IBitmapExportService> bitmapExportService = pUnk;
-		if (m_images && bitmapExportService)
+		// Export each image once a publish, however many fills and bitmaps use it
+		if (m_images && !alreadyExported)
 		{
-			FCM::AutoPtr<FCM::IFCMCalloc> pCalloc;
-#ifdef _WINDOWS
-			fs::path exportPath(bitmapExportPath);
-			FCM::StringRep16 pFilePath = Utils::ToString16(fs::canonical(exportPath).string(), m_pCallback);
-#else
-			FCM::StringRep16 pFilePath = Utils::ToString16(bitmapExportPath, m_pCallback);
-#endif
-			res = bitmapExportService->ExportToFile(pMediaItem, pFilePath, 100);
+			res = ExportImage(libPathName, bitmapExportPath, height, width, pMediaItem);
 			ASSERT(FCM_SUCCESS_CODE(res));
-
-			pCalloc = Utils::GetCallocService(m_pCallback);
-			ASSERT(pCalloc.m_Ptr != NULL);
-
-			pCalloc->Free(pFilePath);
 		}
 
 		bitmapElem.push_back(JSONNode("src", bitmapRelPath));
@@ -369,9 +628,17 @@ namespace PixiJS
 
 		bitmapElem.push_back(JSONNode("patternUnits", "userSpaceOnUse"));
 		bitmapElem.push_back(Utils::ToJSON("patternTransform", matrix1));
+		bitmapElem.push_back(JSONNode("clipped", (bool)clipped));
 
 		m_pathElem->push_back(bitmapElem);
 
+		// Mapped onto the fill's mesh once it has one
+		m_bitmap = width > 0 && height > 0 && InvertMatrix(matrix1, m_bitmapInverse);
+		m_bitmapClipped = clipped != 0;
+		m_bitmapName = name;
+		m_bitmapWidth = width;
+		m_bitmapHeight = height;
+
 		return FCM_SUCCESS;
 	}
 
@@ -403,6 +670,8 @@ namespace PixiJS
 
 		m_gradientColor->push_back(JSONNode("spreadMethod", Utils::ToString(spread)));
 
+		SetGradient(false, spread, matrix, 0);
+
 		m_stopPointArray = new JSONNode(JSON_ARRAY);
 		ASSERT(m_stopPointArray);
 		m_stopPointArray->set_name("stop");
@@ -425,6 +694,7 @@ namespace PixiJS
 		stopEntry.push_back(JSONNode("stopOpacity", (float)(colorPoint.color.alpha / 255.0)));
 
 		m_stopPointArray->push_back(stopEntry);
+		m_gradientStops.push_back(colorPoint);
 
 		return FCM_SUCCESS;
 	}
@@ -492,6 +762,8 @@ namespace PixiJS
 		m_gradientColor->push_back(JSONNode(Utils::ToJSON("gradientTransform", matrix1)));
 		m_gradientColor->push_back(JSONNode("spreadMethod", Utils::ToString(spread)));
 
+		SetGradient(true, spread, matrix, focusPointRatio);
+
 		m_stopPointArray = new JSONNode(JSON_ARRAY);
 		ASSERT(m_stopPointArray);
 		m_stopPointArray->set_name("stop");
@@ -514,16 +786,14 @@ namespace PixiJS
 
 	FCM::Result OutputWriter::StartDefinePath()
 	{
-		// m_pathCmdArray->push_back(JSONNode("", "startPath"));
-		m_pathCmdArray->push_back(JSONNode("", moveTo));
+		WritePathCommand(moveTo);
 		m_firstSegment = true;
 		return FCM_SUCCESS;
 	}
 
 	FCM::Result OutputWriter::EndDefinePath()
 	{
-		m_pathCmdArray->push_back(JSONNode("", closePath));
-		// m_pathCmdArray->push_back(JSONNode("", "endPath"));
+		WritePathCommand(closePath);
 		return FCM_SUCCESS;
 	}
 
@@ -543,13 +813,17 @@ namespace PixiJS
 	// Start of fill region hole
 	FCM::Result OutputWriter::StartDefineHole()
 	{
+		if (m_meshFill)
+		{
+			m_meshHoles.push_back((FCM::U_Int32)(m_meshCoords.size() / 2));
+		}
 		return StartDefinePath();
 	}
 
 	// End of fill region hole
 	FCM::Result OutputWriter::EndDefineHole()
 	{
-		m_pathCmdArray->push_back(JSONNode("", addHole));
+		WritePathCommand(addHole);
 		return FCM_SUCCESS;
 	}
 
@@ -557,39 +831,299 @@ namespace PixiJS
 	// Sets a segment of a path (Used for boundary, holes)
 	FCM::Result OutputWriter::SetSegment(const DOM::Utils::SEGMENT& segment)
 	{
+#ifdef _DEBUG
+		std::clock_t start = std::clock();
+#endif
+		if (m_meshFill)
+		{
+			if (m_firstSegment)
+			{
+				const DOM::Utils::POINT2D& first = segment.segmentType == DOM::Utils::LINE_SEGMENT ?
+					segment.line.endPoint1 : segment.quadBezierCurve.anchor1;
+				AddMeshPoint(first.x, first.y);
+			}
+			if (segment.segmentType == DOM::Utils::LINE_SEGMENT)
+			{
+				AddMeshPoint(segment.line.endPoint2.x, segment.line.endPoint2.y);
+			}
+			else
+			{
+				AddMeshCurve(segment.quadBezierCurve.anchor1,
+					segment.quadBezierCurve.control,
+					segment.quadBezierCurve.anchor2);
+			}
+		}
+
 		if (m_firstSegment)
 		{
 			if (segment.segmentType == DOM::Utils::LINE_SEGMENT)
 			{
-				m_pathCmdArray->push_back(JSONNode("", (double)(segment.line.endPoint1.x)));
-				m_pathCmdArray->push_back(JSONNode("", (double)(segment.line.endPoint1.y)));
+				WritePathPoint(segment.line.endPoint1);
 			}
 			else
 			{
-				m_pathCmdArray->push_back(JSONNode("", (double)(segment.quadBezierCurve.anchor1.x)));
-				m_pathCmdArray->push_back(JSONNode("", (double)(segment.quadBezierCurve.anchor1.y)));
+				WritePathPoint(segment.quadBezierCurve.anchor1);
 			}
 			m_firstSegment = false;
 		}
 
 		if (segment.segmentType == DOM::Utils::LINE_SEGMENT)
 		{
-			m_pathCmdArray->push_back(JSONNode("", lineTo));
-			m_pathCmdArray->push_back(JSONNode("", (double)(segment.line.endPoint2.x)));
-			m_pathCmdArray->push_back(JSONNode("", (double)(segment.line.endPoint2.y)));
+			WritePathCommand(lineTo);
+			WritePathPoint(segment.line.endPoint2);
 		}
 		else
 		{
-			m_pathCmdArray->push_back(JSONNode("", quadraticCurveTo));
-			m_pathCmdArray->push_back(JSONNode("", (double)(segment.quadBezierCurve.control.x)));
-			m_pathCmdArray->push_back(JSONNode("", (double)(segment.quadBezierCurve.control.y)));
-			m_pathCmdArray->push_back(JSONNode("", (double)(segment.quadBezierCurve.anchor2.x)));
-			m_pathCmdArray->push_back(JSONNode("", (double)(segment.quadBezierCurve.anchor2.y)));
+			WritePathCommand(quadraticCurveTo);
+			WritePathPoint(segment.quadBezierCurve.control);
+			WritePathPoint(segment.quadBezierCurve.anchor2);
 		}
 
+		m_segmentCount++;
+#ifdef _DEBUG
+		m_segmentTime += (FCM::Double)(std::clock() - start) / CLOCKS_PER_SEC;
+#endif
 		return FCM_SUCCESS;
 	}
 
+	void OutputWriter::WritePathCommand(unsigned char command)
+	{
+		m_pathData.push_back((char)command);
+	}
+
+	void OutputWriter::WritePathPoint(const DOM::Utils::POINT2D& point)
+	{
+		FCM::S_Int32 x = (FCM::S_Int32)floor(point.x * PATH_PRECISION + 0.5);
+		FCM::S_Int32 y = (FCM::S_Int32)floor(point.y * PATH_PRECISION + 0.5);
+
+		WritePathValue(x - m_pathX);
+		WritePathValue(y - m_pathY);
+
+		m_pathX = x;
+		m_pathY = y;
+	}
+
+	void OutputWriter::WritePathValue(FCM::S_Int32 value)
+	{
+		// Zigzag encode so small negative deltas stay small
+		FCM::U_Int32 bits = ((FCM::U_Int32)value << 1) ^ (FCM::U_Int32)(value >> 31);
+
+		// Then 7 bits per byte, high bit set when more bytes follow
+		while (bits >= 0x80)
+		{
+			m_pathData.push_back((char)((bits & 0x7F) | 0x80));
+			bits >>= 7;
+		}
+		m_pathData.push_back((char)bits);
+	}
+
+	JSONNode OutputWriter::GetPathData()
+	{
+		m_pathBytes += (FCM::U_Int32)m_pathData.size();
+
+		return JSONNode("d", libjson::encode64(
+			(const unsigned char*)m_pathData.data(),
+			m_pathData.size()));
+	}
+
+	void OutputWriter::AddMeshPoint(FCM::Double x, FCM::Double y)
+	{
+		m_meshCoords.push_back(x);
+		m_meshCoords.push_back(y);
+	}
+
+	void OutputWriter::AddMeshCurve(
+		const DOM::Utils::POINT2D& from,
+		const DOM::Utils::POINT2D& control,
+		const DOM::Utils::POINT2D& to)
+	{
+		// n even steps stray at most |from - 2 control + to| / (4 n^2) from the curve
+		FCM::Double dx = from.x - 2.0 * control.x + to.x;
+		FCM::Double dy = from.y - 2.0 * control.y + to.y;
+		int steps = (int)ceil(sqrt(sqrt(dx * dx + dy * dy) / (4.0 * MESH_TOLERANCE)));
+		steps = steps < 1 ? 1 : (steps > MAX_CURVE_STEPS ? MAX_CURVE_STEPS : steps);
+
+		for (int i = 1; i < steps; i++)
+		{
+			FCM::Double t = (FCM::Double)i / steps;
+			FCM::Double u = 1.0 - t;
+			AddMeshPoint(
+				u * u * from.x + 2.0 * u * t * control.x + t * t * to.x,
+				u * u * from.y + 2.0 * u * t * control.y + t * t * to.y);
+		}
+		AddMeshPoint(to.x, to.y);
+	}
+
+	bool OutputWriter::GetMeshData(JSONNode& mesh)
+	{
+		size_t vertexCount = m_meshCoords.size() / 2;
+		if (vertexCount < 3)
+		{
+			return false;
+		}
+		if (vertexCount > MAX_MESH_VERTICES)
+		{
+			m_meshSkipped++;
+			return false;
+		}
+
+		std::clock_t start = std::clock();
+
+		m_meshTriangles.clear();
+		bool triangulated = m_triangulator.Triangulate(m_meshCoords, m_meshHoles, m_meshTriangles);
+
+		m_meshTime += (FCM::Double)(std::clock() - start) / CLOCKS_PER_SEC;
+
+		if (!triangulated)
+		{
+			return false;
+		}
+
+		std::string vertices;
+		vertices.reserve(m_meshCoords.size() * 4);
+		for (size_t i = 0; i < m_meshCoords.size(); i++)
+		{
+			AppendFloat32(vertices, (float)m_meshCoords[i]);
+		}
+
+		std::string indices;
+		indices.reserve(m_meshTriangles.size() * 2);
+		for (size_t i = 0; i < m_meshTriangles.size(); i++)
+		{
+			AppendUInt16(indices, m_meshTriangles[i]);
+		}
+
+		mesh.set_name("mesh");
+		mesh.push_back(JSONNode("vertices", libjson::encode64(
+			(const unsigned char*)vertices.data(), vertices.size())));
+		mesh.push_back(JSONNode("indices", libjson::encode64(
+			(const unsigned char*)indices.data(), indices.size())));
+
+		m_meshCount++;
+		m_meshTriangleCount += (FCM::U_Int32)(m_meshTriangles.size() / 3);
+
+		return true;
+	}
+
+	void OutputWriter::SetGradient(
+		bool radial,
+		DOM::FillStyle::GradientSpread spread,
+		const DOM::Utils::MATRIX2D& matrix,
+		FCM::Double focal)
+	{
+		// A unit in gradient space is GRADIENT_VECTOR_CONSTANT twips before the matrix
+		FCM::Double unit = GRADIENT_VECTOR_CONSTANT / 20;
+		DOM::Utils::MATRIX2D scaled = matrix;
+		scaled.a = (FCM::Float)(matrix.a * unit);
+		scaled.b = (FCM::Float)(matrix.b * unit);
+		scaled.c = (FCM::Float)(matrix.c * unit);
+		scaled.d = (FCM::Float)(matrix.d * unit);
+
+		m_gradientStops.clear();
+
+		// Squashed flat, there's nothing to bake
+		m_gradient = InvertMatrix(scaled, m_gradientInverse);
+
+		m_gradientRadial = radial;
+		m_gradientSpread = spread;
+		m_gradientFocal = focal;
+		m_gradientScaleX = sqrt((FCM::Double)scaled.a * scaled.a + (FCM::Double)scaled.b * scaled.b);
+		m_gradientScaleY = sqrt((FCM::Double)scaled.c * scaled.c + (FCM::Double)scaled.d * scaled.d);
+	}
+
+	void OutputWriter::GetBitmapUVs(std::string& uvs)
+	{
+		const DOM::Utils::MATRIX2D& m = m_bitmapInverse;
+		FCM::Double scaleU = 1.0 / m_bitmapWidth;
+		FCM::Double scaleV = 1.0 / m_bitmapHeight;
+		size_t count = m_meshCoords.size() / 2;
+
+		// Left unclamped, clipped images stretch their edges with clamp to edge sampling
+		uvs.clear();
+		uvs.reserve(count * 8);
+		for (size_t i = 0; i < count; i++)
+		{
+			FCM::Double x = m_meshCoords[i * 2];
+			FCM::Double y = m_meshCoords[i * 2 + 1];
+			AppendFloat32(uvs, (float)((x * m.a + y * m.c + m.tx) * scaleU));
+			AppendFloat32(uvs, (float)((x * m.b + y * m.d + m.ty) * scaleV));
+		}
+	}
+
+	bool OutputWriter::BakeGradient(std::string& uvs)
+	{
+		if (!m_images || m_gradientStops.empty())
+		{
+			return false;
+		}
+
+		// The mesh vertices in gradient space, with their bounds
+		const DOM::Utils::MATRIX2D& m = m_gradientInverse;
+		size_t count = m_meshCoords.size() / 2;
+		m_gradientCoords.resize(count * 2);
+
+		FCM::Double minX = 0, minY = 0, maxX = 0, maxY = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			FCM::Double x = m_meshCoords[i * 2];
+			FCM::Double y = m_meshCoords[i * 2 + 1];
+			FCM::Double gx = x * m.a + y * m.c + m.tx;
+			FCM::Double gy = x * m.b + y * m.d + m.ty;
+			m_gradientCoords[i * 2] = gx;
+			m_gradientCoords[i * 2 + 1] = gy;
+
+			minX = i == 0 || gx < minX ? gx : minX;
+			maxX = i == 0 || gx > maxX ? gx : maxX;
+			minY = i == 0 || gy < minY ? gy : minY;
+			maxY = i == 0 || gy > maxY ? gy : maxY;
+		}
+
+		FCM::U_Int32 x, y;
+		FCM::U_Int32 width, height;
+		bool placed;
+		if (m_gradientRadial)
+		{
+			width = (FCM::U_Int32)ceil((maxX - minX) * m_gradientScaleX / RADIAL_TEXEL_SIZE) + 1;
+			height = (FCM::U_Int32)ceil((maxY - minY) * m_gradientScaleY / RADIAL_TEXEL_SIZE) + 1;
+			width = std::max<FCM::U_Int32>(2, std::min(width, GradientAtlas::MAX_TILE_SIZE));
+			height = std::max<FCM::U_Int32>(2, std::min(height, GradientAtlas::MAX_TILE_SIZE));
+
+			placed = m_gradientAtlas.AddRadialTile(m_gradientStops, m_gradientSpread, m_gradientFocal,
+				minX, minY, maxX, maxY, width, height, x, y);
+		}
+		else
+		{
+			// The ramp runs from -1 to 1 along x, one texel a pixel
+			width = (FCM::U_Int32)ceil((maxX - minX) * m_gradientScaleX) + 1;
+			width = std::max<FCM::U_Int32>(2, std::min(width, GradientAtlas::MAX_RAMP_WIDTH));
+			height = 1;
+
+			placed = m_gradientAtlas.AddLinearRamp(m_gradientStops, m_gradientSpread,
+				(minX + 1.0) * 0.5, (maxX + 1.0) * 0.5, width, x, y);
+		}
+
+		if (!placed)
+		{
+			return false;
+		}
+
+		// Corner texels are centred on the bounds, so filtering stays inside the tile
+		FCM::Double scaleX = maxX > minX ? (width - 1) / (maxX - minX) : 0;
+		FCM::Double scaleY = maxY > minY ? (height - 1) / (maxY - minY) : 0;
+
+		uvs.clear();
+		uvs.reserve(count * 8);
+		for (size_t i = 0; i < count; i++)
+		{
+			AppendFloat32(uvs, (float)(x + 0.5 + (m_gradientCoords[i * 2] - minX) * scaleX));
+			AppendFloat32(uvs, (float)(y + 0.5 + (m_gradientRadial ?
+				(m_gradientCoords[i * 2 + 1] - minY) * scaleY : 0)));
+		}
+
+		m_gradientsBaked++;
+		return true;
+	}
+
 	// Start of stroke group
 	FCM::Result OutputWriter::StartDefineStrokeGroup()
 	{
@@ -630,9 +1164,12 @@ namespace PixiJS
 		m_pathElem = new JSONNode(JSON_NODE);
 		ASSERT(m_pathElem);
 
-		m_pathCmdArray = new JSONNode(JSON_ARRAY);
-		ASSERT(m_pathCmdArray);
-		m_pathCmdArray->set_name("d");
+		m_gradient = false;
+		m_bitmap = false;
+
+		m_pathData.clear();
+		m_pathX = 0;
+		m_pathY = 0;
 
 		return StartDefinePath();
 	}
@@ -641,7 +1178,7 @@ namespace PixiJS
 	// End of a stroke
 	FCM::Result OutputWriter::EndDefineStroke()
 	{
-		m_pathElem->push_back(*m_pathCmdArray);
+		m_pathElem->push_back(GetPathData());
 
 		if (m_strokeStyle.type == SOLID_STROKE_STYLE_TYPE)
 		{
@@ -659,13 +1196,18 @@ namespace PixiJS
 			}
 			m_pathElem->push_back(JSONNode("stroke", true));
 		}
+		if (m_gradient)
+		{
+			m_gradientsSkipped++;
+		}
+		if (m_bitmap)
+		{
+			m_bitmapsSkipped++;
+		}
 		m_pathArray->push_back(*m_pathElem);
 
 		delete m_pathElem;
-		delete m_pathCmdArray;
-
 		m_pathElem = NULL;
-		m_pathCmdArray = NULL;
 
 		return FCM_SUCCESS;
 	}
@@ -684,16 +1226,51 @@ namespace PixiJS
 	{
 		EndDefinePath();
 
-		m_pathElem->push_back(*m_pathCmdArray);
+		m_pathElem->push_back(GetPathData());
 		m_pathElem->push_back(JSONNode("stroke", false));
 
+		bool baked = false;
+		bool meshed = false;
+		if (m_meshFill)
+		{
+			JSONNode mesh(JSON_NODE);
+			if (GetMeshData(mesh))
+			{
+				std::string uvs;
+				if (m_gradient && BakeGradient(uvs))
+				{
+					mesh.push_back(JSONNode("uvs", libjson::encode64(
+						(const unsigned char*)uvs.data(), uvs.size())));
+					baked = true;
+				}
+				else if (m_bitmap)
+				{
+					// Drawn with the exported image, named as in the bitmaps
+					GetBitmapUVs(uvs);
+					mesh.push_back(JSONNode("uvs", libjson::encode64(
+						(const unsigned char*)uvs.data(), uvs.size())));
+					mesh.push_back(JSONNode("image", m_bitmapName));
+					mesh.push_back(JSONNode("repeat", !m_bitmapClipped));
+					m_bitmapsMeshed++;
+				}
+				m_pathElem->push_back(mesh);
+				meshed = true;
+			}
+			m_meshFill = false;
+		}
+		if (m_gradient && !baked)
+		{
+			m_gradientsSkipped++;
+		}
+		if (m_bitmap && !meshed)
+		{
+			m_bitmapsSkipped++;
+		}
+
 		m_pathArray->push_back(*m_pathElem);
 
 		delete m_pathElem;
-		delete m_pathCmdArray;
-
 		m_pathElem = NULL;
-		m_pathCmdArray = NULL;
 
 		return FCM_SUCCESS;
 	}
@@ -718,9 +1295,7 @@ namespace PixiJS
 		bitmapElem.push_back(JSONNode("height", height));
 		bitmapElem.push_back(JSONNode("width", width));
 
-		FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
-
-		FCM::Boolean alreadyExported = GetImageExportFileName(libPathName, name);
+		FCM::Boolean alreadyExported = GetImageExportFileName(libPathName, name, ext);
 
 		if (!alreadyExported)
 		{
@@ -736,43 +1311,28 @@ namespace PixiJS
 			}
 			Utils::GetFileExtension(libPathName, ext);
 			Utils::GetFileNameWithoutExtension(libPathName, name);
-			SetImageExportFileName(libPathName, name);
 
 			if (ext == "")
 			{
 				ext = "png";
 			}
+			SetImageExportFileName(libPathName, name, ext);
 		}
 
 		std::string bitmapExportPath(m_outputImageFolder + name + "." + ext);
 		std::string bitmapRelPath(m_imagesPath + name + "." + ext);
 
-		res = m_pCallback->GetService(DOM::FLA_BITMAP_SERVICE, pUnk.m_Ptr);
-		ASSERT(FCM_SUCCESS_CODE(res));
-
-		FCM::AutoPtr<DOM::Service::Image::IBitmapExportService> bitmapExportService = pUnk;
-		if (m_images && bitmapExportService)
+		// Export each image once a publish, however many fills and bitmaps use it
+		if (m_images && !alreadyExported)
 		{
-			FCM::AutoPtr<FCM::IFCMCalloc> pCalloc;
-#ifdef _WINDOWS
-			fs::path exportPath(bitmapExportPath);
-			FCM::StringRep16 pFilePath = Utils::ToString16(fs::canonical(exportPath).string(), m_pCallback);
-#else
-			FCM::StringRep16 pFilePath = Utils::ToString16(bitmapExportPath, m_pCallback);
-#endif
-			res = bitmapExportService->ExportToFile(pMediaItem, pFilePath, 100);
+			res = ExportImage(libPathName, bitmapExportPath, height, width, pMediaItem);
 			ASSERT(FCM_SUCCESS_CODE(res));
-
-			pCalloc = Utils::GetCallocService(m_pCallback);
-			ASSERT(pCalloc.m_Ptr != NULL);
-
-			pCalloc->Free(pFilePath);
 		}
 
 		bitmapElem.push_back(JSONNode("src", bitmapRelPath));
 		bitmapElem.push_back(JSONNode("name", name));
 
-		m_pBitmapArray->push_back(bitmapElem);
+		WriteToSection(BITMAPS_SECTION, bitmapElem);
 
 		return FCM_SUCCESS;
 	}
@@ -802,11 +1362,7 @@ namespace PixiJS
 		}
 		m_pTextElem->push_back(aaMode);
 
-		std::string txt = displayText;
-		Utils::ReplaceAll(txt, "\n", "\\n");
-		Utils::ReplaceAll(txt, "\r", "\\n");
-		Utils::ReplaceAll(txt, "\t", "");
-		m_pTextElem->push_back(JSONNode("txt", txt));
+		m_pTextElem->push_back(JSONNode("txt", Utils::Escape(displayText, ESCAPE_TEXT)));
 
 		behaviour.set_name("behaviour");
 
@@ -935,7 +1491,7 @@ namespace PixiJS
 		delete m_pTextParaArray;
 		m_pTextParaArray = NULL;
 
-		m_pTextArray->push_back(*m_pTextElem);
+		WriteToSection(TEXTS_SECTION, *m_pTextElem);
 
 		delete m_pTextElem;
 		m_pTextElem = NULL;
@@ -998,7 +1554,7 @@ namespace PixiJS
 		soundElem.push_back(JSONNode("src", soundRelPath));
 		soundElem.push_back(JSONNode("name", name));
 
-		m_pSoundArray->push_back(soundElem);
+		WriteToSection(SOUNDS_SECTION, soundElem);
 
 		return FCM_SUCCESS;
 	}
@@ -1016,6 +1572,7 @@ namespace PixiJS
 		bool html,
 		bool libs,
 		bool images,
+		bool reuseImages,
 		bool sounds,
 		bool compactShapes,
 		bool compressJS,
@@ -1023,12 +1580,54 @@ namespace PixiJS
 		bool loopTimeline,
 		bool spritesheets,
 		int spritesheetSize,
-		double spritesheetScale)
-		: m_pCallback(pCallback),
-		m_outputFile(outputFile),
-		m_outputDataFile(basePath + outputFile + "on"),
-		m_outputImageFolder(basePath + imagesPath),
-		m_outputSoundFolder(basePath + soundsPath),
+		double spritesheetScale,
+		double tweenTolerance,
+		int transformPrecision,
+		bool animationTracks,
+		bool triangulateFills,
+		PublishWorker* pPublishWorker)
+		: m_cacheFile(basePath + outputFile + CACHE_EXTENSION),
+		m_imageManifestFile(basePath + outputFile + IMAGE_MANIFEST_EXTENSION),
+		m_imagesExported(0),
+		m_imagesSkipped(0),
+		m_documentHash(14695981039346656037ULL),
+		m_cachedDocumentHash(0),
+		m_shapeElem(NULL),
+		m_pathArray(NULL),
+		m_pathElem(NULL),
+		m_pathX(0),
+		m_pathY(0),
+		m_pathBytes(0),
+		m_segmentCount(0),
+		m_segmentTime(0),
+		m_firstSegment(false),
+		m_meshFill(false),
+		m_meshCount(0),
+		m_meshTriangleCount(0),
+		m_meshSkipped(0),
+		m_meshTime(0),
+		m_gradient(false),
+		m_gradientRadial(false),
+		m_gradientSpread(DOM::FillStyle::GRADIENT_SPREAD_EXTEND),
+		m_gradientScaleX(0),
+		m_gradientScaleY(0),
+		m_gradientFocal(0),
+		m_gradientsBaked(0),
+		m_gradientsSkipped(0),
+		m_bitmap(false),
+		m_bitmapClipped(false),
+		m_bitmapWidth(0),
+		m_bitmapHeight(0),
+		m_bitmapsMeshed(0),
+		m_bitmapsSkipped(0),
+		m_pCallback(pCallback),
+		m_pPublishWorker(pPublishWorker),
+		m_streaming(false),
+		m_shapeAliasCount(0),
+		m_shapeAliasBytes(0),
+		m_symbolNameLabel(0),
+		m_imageFolderCreated(false),
+		m_soundFolderCreated(false),
 		m_basePath(basePath),
 		m_imagesPath(imagesPath),
 		m_soundsPath(soundsPath),
@@ -1036,58 +1635,55 @@ namespace PixiJS
 		m_libsPath(libsPath),
 		m_stageName(stageName),
 		m_nameSpace(nameSpace),
+		m_outputFile(outputFile),
+		m_outputDataFile(basePath + outputFile + "on"),
+		m_outputImageFolder(basePath + imagesPath),
+		m_outputSoundFolder(basePath + soundsPath),
+		m_spritesheetSize(spritesheetSize),
+		m_spritesheetScale(spritesheetScale),
+		m_tweenTolerance(tweenTolerance),
+		m_transformPrecision(transformPrecision),
+		m_animationTracks(animationTracks),
+		m_triangulateFills(triangulateFills),
+		m_spritesheets(spritesheets),
 		m_html(html),
 		m_libs(libs),
 		m_images(images),
+		m_reuseImages(reuseImages),
 		m_sounds(sounds),
 		m_compactShapes(compactShapes),
 		m_compressJS(compressJS),
 		m_commonJS(commonJS),
-		m_loopTimeline(loopTimeline),
-		m_spritesheets(spritesheets),
-		m_spritesheetSize(spritesheetSize),
-		m_spritesheetScale(spritesheetScale),
-		m_shapeElem(NULL),
-		m_pathArray(NULL),
-		m_pathElem(NULL),
-		m_firstSegment(false),
-		m_symbolNameLabel(0),
-		m_imageFolderCreated(false),
-		m_soundFolderCreated(false)
+		m_loopTimeline(loopTimeline)
 	{
-		m_pRootNode = new JSONNode(JSON_NODE);
-		ASSERT(m_pRootNode);
-
-		m_pShapeArray = new JSONNode(JSON_ARRAY);
-		ASSERT(m_pShapeArray);
-		m_pShapeArray->set_name("Shapes");
-
-		m_pTimelineArray = new JSONNode(JSON_ARRAY);
-		ASSERT(m_pTimelineArray);
-		m_pTimelineArray->set_name("Timelines");
-
-		m_pBitmapArray = new JSONNode(JSON_ARRAY);
-		ASSERT(m_pBitmapArray);
-		m_pBitmapArray->set_name("Bitmaps");
+		m_strokeStyle.type = INVALID_STROKE_STYLE_TYPE;
 
-		m_pTextArray = new JSONNode(JSON_ARRAY);
-		ASSERT(m_pTextArray);
-		m_pTextArray->set_name("Texts");
+		ReadCache();
+		if (m_reuseImages)
+		{
+			ReadImageManifest();
+		}
+		OpenSections();
 
-		m_pSoundArray = new JSONNode(JSON_ARRAY);
-		ASSERT(m_pSoundArray);
-		m_pSoundArray->set_name("Sounds");
-		m_strokeStyle.type = INVALID_STROKE_STYLE_TYPE;
+		// Spritesheets may need Electron, which can't take a stream
+		if (m_pPublishWorker && !(m_images && m_spritesheets))
+		{
+#ifdef _DEBUG
+			m_streaming = m_pPublishWorker->BeginStream(m_outputDataFile, true);
+#else
+			m_streaming = m_pPublishWorker->BeginStream(m_outputDataFile, false);
+#endif
+		}
 	}
 
 	OutputWriter::~OutputWriter()
 	{
-		delete m_pBitmapArray;
-		delete m_pSoundArray;
-		delete m_pTimelineArray;
-		delete m_pShapeArray;
-		delete m_pTextArray;
-		delete m_pRootNode;
+		// Cleanup if the document was never finished
+		if (m_streaming)
+		{
+			m_pPublishWorker->CancelStream();
+		}
+		RemoveSections();
 	}
 
 	FCM::Result OutputWriter::StartPreview(FCM::PIFCMCallback pCallback)
@@ -1134,16 +1730,18 @@ namespace PixiJS
 		return res;
 	}
 
-	FCM::Boolean OutputWriter::GetImageExportFileName(const std::string& libPathName, std::string& name)
+	FCM::Boolean OutputWriter::GetImageExportFileName(const std::string& libPathName, std::string& name, std::string& ext)
 	{
-		std::map<std::string, std::string>::iterator it = m_imageMap.find(libPathName);
+		std::map<std::string, std::pair<std::string, std::string> >::iterator it = m_imageMap.find(libPathName);
 
 		name = "";
+		ext = "";
 
 		if (it != m_imageMap.end())
 		{
 			// Image already exported
-			name = it->second;
+			name = it->second.first;
+			ext = it->second.second;
 			return true;
 		}
 
@@ -1151,12 +1749,12 @@ namespace PixiJS
 	}
 
 
-	void OutputWriter::SetImageExportFileName(const std::string& libPathName, const std::string& name)
+	void OutputWriter::SetImageExportFileName(const std::string& libPathName, const std::string& name, const std::string& ext)
 	{
 		// Assumption: Name is not already present in the map
 		ASSERT(m_imageMap.find(libPathName) == m_imageMap.end());
 
-		m_imageMap.insert(std::pair<std::string, std::string>(libPathName, name));
+		m_imageMap.insert(std::make_pair(libPathName, std::make_pair(name, ext)));
 	}
 
 	bool OutputWriter::SaveFromTemplate(const std::string &in, const std::string &out)
@@ -1168,32 +1766,292 @@ namespace PixiJS
 		std::string templatePath(extensionPath + TEMPLATE_FOLDER_NAME + in);
 		std::string outputPath(m_basePath + out);
 
-		std::ifstream inFile(templatePath.c_str());
-		if (!inFile)
+		FCM::U_Int64 modified = 0;
+		bool hasTime = Utils::GetModifiedTime(templatePath, modified);
+
+		std::map<std::string, ParsedTemplate>::iterator cached = templateCache.find(templatePath);
+		if (cached == templateCache.end() || !hasTime || cached->second.modified != modified)
 		{
-			return false;
+			std::ifstream inFile(templatePath.c_str());
+			if (!inFile)
+			{
+				return false;
+			}
+			std::stringstream strStream;
+			strStream << inFile.rdbuf();
+
+			ParsedTemplate& parsed = templateCache[templatePath];
+			ParseTemplate(strStream.str(), parsed);
+			parsed.modified = modified;
+			cached = templateCache.find(templatePath);
+		}
+		const ParsedTemplate& parsed = cached->second;
+
+		// Placeholders without a substitution are written as they are
+		std::fstream file;
+		Utils::OpenFStream(outputPath, file, std::ios_base::trunc | std::ios_base::out, m_pCallback);
+		for (size_t i = 0; i < parsed.keys.size(); i++)
+		{
+			file << parsed.text[i];
+
+			std::map<std::string, std::string>::const_iterator sub = m_substitutions.find(parsed.keys[i]);
+			if (sub != m_substitutions.end())
+			{
+				file << sub->second;
+			}
+			else
+			{
+				file << "${" << parsed.keys[i] << "}";
+			}
+		}
+		file << parsed.text.back();
+		file.close();
+
+		return true;
+	}
+
+	void OutputWriter::OpenSections()
+	{
+		for (int i = 0; i < SECTION_COUNT; i++)
+		{
+			m_sectionPaths[i] = m_outputDataFile + "." + sectionNames[i] + ".tmp";
+			m_sectionCounts[i] = 0;
+			Utils::OpenFStream(m_sectionPaths[i], m_sectionFiles[i], std::ios_base::trunc | std::ios_base::out, m_pCallback);
+		}
+	}
+
+	void OutputWriter::WriteToSection(OutputSection section, const JSONNode& node)
+	{
+#ifdef _DEBUG
+		WriteToSection(section, node.write_formatted());
+#else
+		WriteToSection(section, node.write());
+#endif
+	}
+
+	void OutputWriter::WriteToSection(OutputSection section, const std::string& content)
+	{
+		std::fstream& file = m_sectionFiles[section];
+		m_documentHash = (m_documentHash ^ Utils::Hash(content) ^ section) * 1099511628211ULL;
+
+		if (m_sectionCounts[section] > 0)
+		{
+			file << ",";
+		}
+		m_sectionCounts[section]++;
+
+		file << content;
+
+		// Still written to the section file, which is the fallback if the stream fails
+		if (m_streaming)
+		{
+			m_pPublishWorker->StreamFragment(sectionNames[section], content);
+		}
+	}
+
+	void OutputWriter::CloseSections(const JSONNode& meta)
+	{
+		std::fstream file;
+		Utils::OpenFStream(m_outputDataFile, file, std::ios_base::trunc | std::ios_base::out, m_pCallback);
+
+		// Same layout as writing a single root node, so the
+		// output matches a call to JSONNode::write()
+		file << "{";
+		for (int i = 0; i < SECTION_COUNT; i++)
+		{
+			m_sectionFiles[i].close();
+
+			if (i > 0)
+			{
+				file << ",";
+			}
+			file << "\"" << sectionNames[i] << "\":[";
+
+			if (m_sectionCounts[i] > 0)
+			{
+				std::fstream section;
+				Utils::OpenFStream(m_sectionPaths[i], section, std::ios_base::in, m_pCallback);
+				file << section.rdbuf();
+				section.close();
+			}
+			file << "]";
+		}
+		file << ",\"_meta\":";
+#ifdef _DEBUG
+		file << meta.write_formatted();
+#else
+		file << meta.write();
+#endif
+		file << "}";
+		file.close();
+
+		RemoveSections();
+	}
+
+	void OutputWriter::RemoveSections()
+	{
+		for (int i = 0; i < SECTION_COUNT; i++)
+		{
+			if (m_sectionPaths[i].empty())
+			{
+				continue;
+			}
+			if (m_sectionFiles[i].is_open())
+			{
+				m_sectionFiles[i].close();
+			}
+			std::remove(m_sectionPaths[i].c_str());
+			m_sectionPaths[i].clear();
+		}
+	}
+
+	void OutputWriter::ReadCache()
+	{
+		std::fstream file;
+		Utils::OpenFStream(m_cacheFile, file, std::ios_base::in, m_pCallback);
+		if (!file.is_open())
+		{
+			return;
+		}
+
+		file >> std::hex >> m_cachedDocumentHash;
+		file.close();
+	}
+
+	void OutputWriter::WriteCache()
+	{
+		std::fstream file;
+		Utils::OpenFStream(m_cacheFile, file, std::ios_base::trunc | std::ios_base::out, m_pCallback);
+
+		file << std::hex << m_documentHash << "\n";
+		file.close();
+	}
+
+	FCM::Result OutputWriter::ExportImage(
+		const std::string& libPathName,
+		const std::string& exportPath,
+		FCM::S_Int32 height,
+		FCM::S_Int32 width,
+		DOM::LibraryItem::PIMediaItem pMediaItem)
+	{
+		FCM::Result res;
+		FCM::U_Int64 fileHash;
+		std::map<std::string, IMAGE_MANIFEST_ENTRY>::iterator it = m_imageManifest.find(libPathName);
+
+		// Skip the export if the file we wrote last time is still there, untouched.
+		// The manifest is only read with Reuse Images on, an edited bitmap of
+		// the same size would otherwise never be exported again.
+		if (it != m_imageManifest.end() &&
+			it->second.exportPath == exportPath &&
+			it->second.height == height &&
+			it->second.width == width &&
+			HashFile(exportPath, fileHash) &&
+			it->second.fileHash == fileHash)
+		{
+			m_imagesSkipped++;
+			return FCM_SUCCESS;
 		}
-		std::stringstream strStream;
-		strStream << inFile.rdbuf();
-		std::string content(strStream.str());
 
-		std::map<std::string, std::string>::const_iterator i;
-		for (i = m_substitutions.begin(); i != m_substitutions.end(); i++)
+		FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
+		res = m_pCallback->GetService(DOM::FLA_BITMAP_SERVICE, pUnk.m_Ptr);
+		ASSERT(FCM_SUCCESS_CODE(res));
+
+		FCM::AutoPtr<DOM::Service::Image::IBitmapExportService> bitmapExportService = pUnk;
+		if (!bitmapExportService)
 		{
-			Utils::ReplaceAll(content, "${" + i->first + "}", i->second);
+			return FCM_SERVICE_NOT_FOUND;
 		}
 
-		// Save the file
-		Save(outputPath, content);
+		FCM::AutoPtr<FCM::IFCMCalloc> pCalloc;
+#ifdef _WINDOWS
+		fs::path path(exportPath);
+		FCM::StringRep16 pFilePath = Utils::ToString16(fs::canonical(path).string(), m_pCallback);
+#else
+		FCM::StringRep16 pFilePath = Utils::ToString16(exportPath, m_pCallback);
+#endif
+		res = bitmapExportService->ExportToFile(pMediaItem, pFilePath, 100);
+		ASSERT(FCM_SUCCESS_CODE(res));
+
+		pCalloc = Utils::GetCallocService(m_pCallback);
+		ASSERT(pCalloc.m_Ptr != NULL);
+
+		pCalloc->Free(pFilePath);
 
+		if (FCM_SUCCESS_CODE(res) && HashFile(exportPath, fileHash))
+		{
+			IMAGE_MANIFEST_ENTRY entry;
+			entry.exportPath = exportPath;
+			entry.height = height;
+			entry.width = width;
+			entry.fileHash = fileHash;
+			m_imageManifest[libPathName] = entry;
+		}
+		m_imagesExported++;
+
+		return res;
+	}
+
+	bool OutputWriter::HashFile(const std::string& path, FCM::U_Int64& hash)
+	{
+		std::fstream file;
+		Utils::OpenFStream(path, file, std::ios_base::in | std::ios_base::binary, m_pCallback);
+		if (!file.is_open())
+		{
+			return false;
+		}
+		std::stringstream content;
+		content << file.rdbuf();
+		file.close();
+
+		hash = Utils::Hash(content.str());
 		return true;
 	}
 
-	void OutputWriter::Save(const std::string &outputFile, const std::string &content)
+	void OutputWriter::ReadImageManifest()
 	{
 		std::fstream file;
-		Utils::OpenFStream(outputFile, file, std::ios_base::trunc | std::ios_base::out, m_pCallback);
-		file << content;
+		Utils::OpenFStream(m_imageManifestFile, file, std::ios_base::in, m_pCallback);
+		if (!file.is_open())
+		{
+			return;
+		}
+
+		// One line per image: library name, export path, height, width, file hash
+		std::string line;
+		while (std::getline(file, line))
+		{
+			std::stringstream fields(line);
+			std::string name;
+			IMAGE_MANIFEST_ENTRY entry;
+
+			if (std::getline(fields, name, '\t') &&
+				std::getline(fields, entry.exportPath, '\t') &&
+				fields >> entry.height >> entry.width >> std::hex >> entry.fileHash)
+			{
+				m_imageManifest[name] = entry;
+			}
+		}
+		file.close();
+	}
+
+	void OutputWriter::WriteImageManifest()
+	{
+		std::fstream file;
+		Utils::OpenFStream(m_imageManifestFile, file, std::ios_base::trunc | std::ios_base::out, m_pCallback);
+
+		std::map<std::string, IMAGE_MANIFEST_ENTRY>::const_iterator it;
+		for (it = m_imageManifest.begin(); it != m_imageManifest.end(); it++)
+		{
+			file << it->first << "\t" << it->second.exportPath << "\t"
+				<< std::dec << it->second.height << " " << it->second.width << " "
+				<< std::hex << it->second.fileHash << "\n";
+		}
 		file.close();
 	}
+
+	void OutputWriter::RemoveCache(const std::string& basePath, const std::string& outputFile)
+	{
+		std::remove((basePath + outputFile + CACHE_EXTENSION).c_str());
+		std::remove((basePath + outputFile + IMAGE_MANIFEST_EXTENSION).c_str());
+	}
 };
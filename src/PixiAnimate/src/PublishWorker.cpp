@@ -0,0 +1,474 @@
+//
+//  PublishWorker.cpp
+//  PixiAnimate.mp
+//
+
+#ifdef _WINDOWS
+#include <WinSock2.h>
+#pragma comment(lib, "Ws2_32.lib")
+#include <Windows.h>
+#include <bcrypt.h>
+#pragma comment(lib, "Bcrypt.lib")
+#else
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+#include "PublishWorker.h"
+#include "PluginConfiguration.h"
+#include "Utils.h"
+#include "libjson.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WINDOWS
+typedef SOCKET WorkerSocket;
+#define CLOSE_WORKER_SOCKET(sock) closesocket((WorkerSocket)(sock))
+#define SLEEP_MS(ms) Sleep(ms)
+#define RECEIVE_TIMED_OUT() (WSAGetLastError() == WSAETIMEDOUT)
+#else
+typedef int WorkerSocket;
+#define INVALID_SOCKET (-1)
+#define CLOSE_WORKER_SOCKET(sock) close((WorkerSocket)(sock))
+#define SLEEP_MS(ms) usleep((ms) * 1000)
+#define RECEIVE_TIMED_OUT() (errno == EAGAIN || errno == EWOULDBLOCK)
+#endif
+
+namespace PixiJS
+{
+	// How long to wait for a new worker to start listening
+	static const int START_TIMEOUT_MS = 10000;
+	static const int START_POLL_MS = 50;
+
+	// How long a ping or quit may take to be answered
+	static const int PING_TIMEOUT_MS = 2000;
+
+	// How long a job may take to compile, or to take a frame of its stream,
+	// before the worker is taken for hung and Node is run without it
+	static const int JOB_TIMEOUT_MS = 5 * 60 * 1000;
+
+	static const std::string portFileName = "publish-worker.port";
+
+	static const std::string tokenFileName = "publish-worker.token";
+
+	// Bytes of randomness in a token
+	static const int TOKEN_BYTES = 16;
+
+	// Random token from the OS generator, false if it isn't available
+	static bool GenerateToken(std::string& token)
+	{
+		unsigned char bytes[TOKEN_BYTES];
+#ifdef _WINDOWS
+		if (!BCRYPT_SUCCESS(BCryptGenRandom(NULL, bytes, sizeof(bytes), BCRYPT_USE_SYSTEM_PREFERRED_RNG)))
+		{
+			return false;
+		}
+#else
+		std::ifstream random("/dev/urandom", std::ios::in | std::ios::binary);
+		if (!random.read((char*)bytes, sizeof(bytes)))
+		{
+			return false;
+		}
+#endif
+		static const char hex[] = "0123456789abcdef";
+		token.clear();
+		for (int i = 0; i < TOKEN_BYTES; i++)
+		{
+			token.push_back(hex[bytes[i] >> 4]);
+			token.push_back(hex[bytes[i] & 0xF]);
+		}
+		return true;
+	}
+
+	// Write the token to a file only this user can read
+	static bool WriteTokenFile(const std::string& path, const std::string& token)
+	{
+		std::remove(path.c_str());
+#ifdef _WINDOWS
+		// The app temp dir is already private to the user
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::trunc);
+		file << token;
+		return file.good();
+#else
+		int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+		if (fd < 0)
+		{
+			return false;
+		}
+		bool written = write(fd, token.c_str(), token.size()) == (ssize_t)token.size();
+		close(fd);
+		return written;
+#endif
+	}
+
+	PublishWorker::PublishWorker(FCM::PIFCMCallback pCallback) :
+		m_pCallback(pCallback),
+		m_port(0),
+		m_socketsReady(true),
+		m_hung(false),
+		m_timedOut(false),
+		m_streamSocket(NO_SOCKET),
+		m_streamFailed(false)
+	{
+#ifdef _WINDOWS
+		WSADATA wsaData;
+		m_socketsReady = WSAStartup(MAKEWORD(2, 2), &wsaData) == 0;
+#endif
+		std::string tempDir;
+		if (FCM_SUCCESS_CODE(Utils::GetAppTempDir(m_pCallback, tempDir)))
+		{
+			m_portFile = tempDir + portFileName;
+			m_tokenFile = tempDir + tokenFileName;
+		}
+	}
+
+	PublishWorker::~PublishWorker()
+	{
+		CloseStream();
+		Stop();
+#ifdef _WINDOWS
+		if (m_socketsReady)
+		{
+			WSACleanup();
+		}
+#endif
+	}
+
+	FCM::Result PublishWorker::Publish(const std::string& dataFile, bool debug, bool& compiled)
+	{
+		compiled = false;
+
+		if (!m_socketsReady || m_hung || m_portFile.empty())
+		{
+			return FCM_GENERAL_ERROR;
+		}
+
+		// Restart the worker if it quit or crashed since the last publish
+		if (!Ping() && !Start())
+		{
+			return FCM_GENERAL_ERROR;
+		}
+
+		JSONNode request(JSON_NODE);
+		request.push_back(JSONNode("token", m_token));
+		request.push_back(JSONNode("command", "publish"));
+		request.push_back(JSONNode("src", dataFile));
+		request.push_back(JSONNode("debug", debug));
+
+		std::string response;
+		if (!Send(request.write(), response, JOB_TIMEOUT_MS))
+		{
+			OnJobFailed();
+			return FCM_GENERAL_ERROR;
+		}
+
+		// The compiler ran, report its errors rather than running it again
+		if (response.compare(0, 6, "error ") == 0)
+		{
+			Utils::Trace(m_pCallback, "ERROR: %s\n", response.substr(6).c_str());
+		}
+		else
+		{
+			compiled = true;
+		}
+		return FCM_SUCCESS;
+	}
+
+	bool PublishWorker::BeginStream(const std::string& dataFile, bool debug)
+	{
+		CloseStream();
+
+		if (!m_socketsReady || m_hung || m_portFile.empty())
+		{
+			return false;
+		}
+
+		if (!Ping() && !Start())
+		{
+			return false;
+		}
+
+		// The data file isn't written, it only tells the worker where the output goes
+		JSONNode request(JSON_NODE);
+		request.push_back(JSONNode("token", m_token));
+		request.push_back(JSONNode("command", "stream"));
+		request.push_back(JSONNode("src", dataFile));
+		request.push_back(JSONNode("debug", debug));
+
+		m_streamSocket = Connect();
+		if (m_streamSocket == NO_SOCKET)
+		{
+			return false;
+		}
+		m_streamFailed = !SendAll(m_streamSocket, request.write() + "\n");
+		return !m_streamFailed;
+	}
+
+	bool PublishWorker::StreamFragment(const std::string& section, const std::string& content)
+	{
+		return SendFrame("F " + section, content);
+	}
+
+	FCM::Result PublishWorker::EndStream(const std::string& meta, bool& compiled)
+	{
+		compiled = false;
+
+		if (!SendFrame("M _meta", meta))
+		{
+			CloseStream();
+			return FCM_GENERAL_ERROR;
+		}
+
+		std::string response;
+		bool received = Receive(m_streamSocket, response, JOB_TIMEOUT_MS);
+		m_streamSocket = NO_SOCKET;
+
+		if (!received)
+		{
+			OnJobFailed();
+			return FCM_GENERAL_ERROR;
+		}
+		if (response.compare(0, 6, "error ") == 0)
+		{
+			Utils::Trace(m_pCallback, "ERROR: %s\n", response.substr(6).c_str());
+		}
+		else
+		{
+			compiled = true;
+		}
+		return FCM_SUCCESS;
+	}
+
+	void PublishWorker::CancelStream()
+	{
+		// The worker drops a job whose connection closes before the _meta frame
+		CloseStream();
+	}
+
+	bool PublishWorker::SendFrame(const std::string& header, const std::string& content)
+	{
+		std::stringstream frame;
+		frame << header << " " << content.size() << "\n";
+
+		if (m_streamSocket != NO_SOCKET && !m_streamFailed)
+		{
+			m_streamFailed = !SendAll(m_streamSocket, frame.str()) || !SendAll(m_streamSocket, content);
+		}
+		return m_streamSocket != NO_SOCKET && !m_streamFailed;
+	}
+
+	void PublishWorker::CloseStream()
+	{
+		if (m_streamSocket != NO_SOCKET)
+		{
+			CLOSE_WORKER_SOCKET(m_streamSocket);
+			m_streamSocket = NO_SOCKET;
+		}
+		m_streamFailed = false;
+	}
+
+	void PublishWorker::Stop()
+	{
+		// A hung worker can't take the request, it quits once idle instead
+		if (m_port > 0 && !m_hung)
+		{
+			std::string response;
+			Send(Request("quit"), response, PING_TIMEOUT_MS);
+			m_port = 0;
+		}
+	}
+
+	bool PublishWorker::Start()
+	{
+		std::string extensionPath;
+		Utils::GetExtensionPath(extensionPath, m_pCallback);
+
+		std::remove(m_portFile.c_str());
+		m_port = 0;
+
+		// Keeps other local processes from sending jobs. It isn't put on the
+		// command line, which they can read, the worker deletes the file.
+		if (!GenerateToken(m_token) || !WriteTokenFile(m_tokenFile, m_token))
+		{
+			Utils::Trace(m_pCallback, "Publish worker token couldn't be created, publishing without it\n");
+			return false;
+		}
+
+		std::string compiler = extensionPath + NODE_COMPILER_CLI;
+		std::string args = "\"" + compiler + "\" --serve \"" + m_portFile + "\" --token-file \"" + m_tokenFile + "\"";
+		if (!Utils::LaunchNode(args))
+		{
+			std::remove(m_tokenFile.c_str());
+			return false;
+		}
+
+		for (int waited = 0; waited < START_TIMEOUT_MS; waited += START_POLL_MS)
+		{
+			SLEEP_MS(START_POLL_MS);
+
+			if (ReadPort() && Ping())
+			{
+				return true;
+			}
+		}
+
+		Utils::Trace(m_pCallback, "Publish worker didn't start, publishing without it\n");
+		m_port = 0;
+		return false;
+	}
+
+	bool PublishWorker::Ping()
+	{
+		std::string response;
+		return m_port > 0 && Send(Request("ping"), response, PING_TIMEOUT_MS) && response == "pong";
+	}
+
+	bool PublishWorker::ReadPort()
+	{
+		std::ifstream file(m_portFile.c_str());
+		if (!file)
+		{
+			return false;
+		}
+		int port = 0;
+		file >> port;
+		m_port = port;
+		return m_port > 0;
+	}
+
+	std::string PublishWorker::Request(const std::string& command)
+	{
+		JSONNode request(JSON_NODE);
+		request.push_back(JSONNode("token", m_token));
+		request.push_back(JSONNode("command", command));
+		return request.write();
+	}
+
+	bool PublishWorker::Send(const std::string& request, std::string& response, int timeoutMs)
+	{
+		size_t sock = Connect();
+		if (sock == NO_SOCKET)
+		{
+			return false;
+		}
+
+		if (!SendAll(sock, request + "\n"))
+		{
+			CLOSE_WORKER_SOCKET(sock);
+			return false;
+		}
+		return Receive(sock, response, timeoutMs);
+	}
+
+	size_t PublishWorker::Connect()
+	{
+		if (m_port <= 0)
+		{
+			return NO_SOCKET;
+		}
+
+		WorkerSocket sock = socket(AF_INET, SOCK_STREAM, 0);
+		if (sock == INVALID_SOCKET)
+		{
+			return NO_SOCKET;
+		}
+
+#ifdef SO_NOSIGPIPE
+		// Writing to a worker that died must fail rather than raise SIGPIPE in the host
+		int noSigPipe = 1;
+		setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+
+		sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons((unsigned short)m_port);
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		if (connect(sock, (struct sockaddr *) &addr, sizeof(addr)) != 0)
+		{
+			CLOSE_WORKER_SOCKET(sock);
+			return NO_SOCKET;
+		}
+
+		// A worker that stops reading mustn't block the stream forever
+		SetTimeout((size_t)sock, SO_SNDTIMEO, JOB_TIMEOUT_MS);
+		return (size_t)sock;
+	}
+
+	void PublishWorker::SetTimeout(size_t sock, int option, int timeoutMs)
+	{
+#ifdef _WINDOWS
+		DWORD timeout = (DWORD)timeoutMs;
+		setsockopt((WorkerSocket)sock, SOL_SOCKET, option, (const char*)&timeout, sizeof(timeout));
+#else
+		struct timeval timeout;
+		timeout.tv_sec = timeoutMs / 1000;
+		timeout.tv_usec = (timeoutMs % 1000) * 1000;
+		setsockopt((WorkerSocket)sock, SOL_SOCKET, option, &timeout, sizeof(timeout));
+#endif
+	}
+
+	void PublishWorker::OnJobFailed()
+	{
+		// Hung rather than gone, a new worker would queue behind it
+		if (m_timedOut)
+		{
+			m_hung = true;
+			Utils::Trace(m_pCallback, "Publish worker didn't answer, publishing without it\n");
+		}
+	}
+
+	bool PublishWorker::SendAll(size_t sock, const std::string& data)
+	{
+		size_t sent = 0;
+		while (sent < data.size())
+		{
+			int n = send((WorkerSocket)sock, data.c_str() + sent, (int)(data.size() - sent), 0);
+			if (n <= 0)
+			{
+				return false;
+			}
+			sent += n;
+		}
+		return true;
+	}
+
+	bool PublishWorker::Receive(size_t sock, std::string& response, int timeoutMs)
+	{
+		// Blocks until the job is done, the connection drops if the worker dies
+		SetTimeout(sock, SO_RCVTIMEO, timeoutMs);
+		m_timedOut = false;
+
+		response.clear();
+		char buffer[512];
+		int n = 0;
+		while (response.find('\n') == std::string::npos &&
+			(n = recv((WorkerSocket)sock, buffer, sizeof(buffer), 0)) > 0)
+		{
+			response.append(buffer, n);
+		}
+		if (n < 0 && RECEIVE_TIMED_OUT())
+		{
+			m_timedOut = true;
+		}
+		CLOSE_WORKER_SOCKET(sock);
+
+		size_t end = response.find('\n');
+		if (end == std::string::npos)
+		{
+			return false;
+		}
+		response.erase(end);
+		return true;
+	}
+};
@@ -44,6 +44,9 @@
 #include "LibraryItem/IFontItem.h"
 #include "LibraryItem/ISymbolItem.h"
 #include "ILibraryItem.h"
+#include "ILayer.h"
+#include "IFrame.h"
+#include "ITween.h"
 
 #include "FrameElement/IButton.h"
 #include "FrameElement/IClassicText.h"
@@ -59,6 +62,8 @@
 #include "Service/Shape/IEdge.h"
 #include "Service/Shape/IShapeService.h"
 #include "Service/Image/IBitmapExportService.h"
+#include "Service/Tween/ITweenerService.h"
+#include "Service/Tween/IPropertyIDs.h"
 
 
 #include "Utils/DOMTypes.h"
@@ -73,6 +78,8 @@
 
 #include "Exporter/Service/ISWFExportService.h"
 #include <algorithm>
+#include <cmath>
+#include <ctime>
 #include "PluginConfiguration.h"
 
 namespace PixiJS
@@ -80,7 +87,8 @@ namespace PixiJS
 
 	/* ----------------------------------------------------- CPublisher */
 
-	CPublisher::CPublisher()
+	CPublisher::CPublisher() :
+		m_electronChecked(false)
 	{
 
 	}
@@ -149,6 +157,9 @@ namespace PixiJS
 			return res;
 		}
 
+		m_basePath = basePath;
+		m_outputFile = outputFile;
+
 		// Create the output directory
 		Utils::CreateDir(basePath, GetCallback());
 
@@ -188,10 +199,15 @@ namespace PixiJS
 
 #ifdef _WINDOWS
 
-		if (Utils::RunElectron("--version") != 0)
+		// Starting Electron just for its version is slow, only do it once
+		if (!m_electronChecked)
 		{
-			Utils::Trace(GetCallback(), "ERROR: Electron is required to be installed in your global NPM package repository. Install by running the following from a commandline:\n\n\tnpm install electron -g");
-			return FCM_GENERAL_ERROR;
+			if (Utils::RunElectron("--version") != 0)
+			{
+				Utils::Trace(GetCallback(), "ERROR: Electron is required to be installed in your global NPM package repository. Install by running the following from a commandline:\n\n\tnpm install electron -g");
+				return FCM_GENERAL_ERROR;
+			}
+			m_electronChecked = true;
 		}
 
 #else
@@ -218,6 +234,7 @@ namespace PixiJS
 		bool html(true);
 		bool libs(true);
 		bool images(true);
+		bool reuseImages(false);
 		bool sounds(true);
 		bool compactShapes(true);
 		bool compressJS(true);
@@ -227,6 +244,12 @@ namespace PixiJS
 		bool spritesheets(true);
 		int spritesheetSize;
 		double spritesheetScale;
+		double tweenTolerance(0.0);
+		bool nativeTweens(false);
+		int transformPrecision(3);
+		bool animationTracks(false);
+		bool triangulateFills(false);
+		double pathTolerance(0.0);
 
 		std::string htmlPath;
 		std::string stageName;
@@ -250,6 +273,10 @@ namespace PixiJS
 		Utils::ReadStringToBool(publishSettings, (FCM::StringRep8)DICT_COMMON_JS, commonJS);
 		Utils::ReadStringToBool(publishSettings, (FCM::StringRep8)DICT_LOOP_TIMELINE, loopTimeline);
 		Utils::ReadStringToBool(publishSettings, (FCM::StringRep8)DICT_SPRITESHEETS, spritesheets);
+		Utils::ReadStringToBool(publishSettings, (FCM::StringRep8)DICT_NATIVE_TWEENS, nativeTweens);
+		Utils::ReadStringToBool(publishSettings, (FCM::StringRep8)DICT_ANIMATION_TRACKS, animationTracks);
+		Utils::ReadStringToBool(publishSettings, (FCM::StringRep8)DICT_TRIANGULATE_FILLS, triangulateFills);
+		Utils::ReadStringToBool(publishSettings, (FCM::StringRep8)DICT_REUSE_IMAGES, reuseImages);
 		Utils::ReadString(publishSettings, (FCM::StringRep8)DICT_LIBS_PATH, libsPath);
 		Utils::ReadString(publishSettings, (FCM::StringRep8)DICT_IMAGES_PATH, imagesPath);
 		Utils::ReadString(publishSettings, (FCM::StringRep8)DICT_SOUNDS_PATH, soundsPath);
@@ -259,6 +286,32 @@ namespace PixiJS
 		Utils::ReadStringToInt(publishSettings, (FCM::StringRep8)DICT_SPRITESHEET_SIZE, spritesheetSize);
 		Utils::ReadStringToFloat(publishSettings, (FCM::StringRep8)DICT_SPRITESHEET_SCALE, spritesheetScale);
 
+		// Missing from settings saved before it was added, keep the old 3 places
+		std::string transformPrecisionSetting;
+		Utils::ReadString(publishSettings, (FCM::StringRep8)DICT_TRANSFORM_PRECISION, transformPrecisionSetting);
+		if (!transformPrecisionSetting.empty())
+		{
+			transformPrecision = atoi(transformPrecisionSetting.c_str());
+			transformPrecision = transformPrecision < 0 ? 0 : (transformPrecision > 3 ? 3 : transformPrecision);
+		}
+
+		// Missing from settings saved before tweens were fitted, negative turns it off.
+		// Above 0 the expanded frames may differ from the source by up to the tolerance.
+		std::string tweenToleranceSetting;
+		Utils::ReadString(publishSettings, (FCM::StringRep8)DICT_TWEEN_TOLERANCE, tweenToleranceSetting);
+		if (!tweenToleranceSetting.empty())
+		{
+			tweenTolerance = strtod(tweenToleranceSetting.c_str(), NULL);
+		}
+
+		// Missing from settings saved before paths were simplified, 0 turns it off
+		std::string pathToleranceSetting;
+		Utils::ReadString(publishSettings, (FCM::StringRep8)DICT_PATH_TOLERANCE, pathToleranceSetting);
+		if (!pathToleranceSetting.empty())
+		{
+			pathTolerance = strtod(pathToleranceSetting.c_str(), NULL);
+		}
+
 		if (spritesheetScale == 0.0)
 		{
 			spritesheetScale = 1.0;
@@ -281,6 +334,12 @@ namespace PixiJS
 		Utils::Trace(GetCallback(), " -> Compress JS : %s\n", Utils::ToString(compressJS).c_str());
 		Utils::Trace(GetCallback(), " -> Common JS : %s\n", Utils::ToString(commonJS).c_str());
 		Utils::Trace(GetCallback(), " -> Loop Timeline : %s\n", Utils::ToString(loopTimeline).c_str());
+		Utils::Trace(GetCallback(), " -> Tween Tolerance : %.2f\n", tweenTolerance);
+		Utils::Trace(GetCallback(), " -> Native Tweens : %s\n", Utils::ToString(nativeTweens).c_str());
+		Utils::Trace(GetCallback(), " -> Transform Precision : %s\n", Utils::ToString(transformPrecision).c_str());
+		Utils::Trace(GetCallback(), " -> Animation Tracks : %s\n", Utils::ToString(animationTracks).c_str());
+		Utils::Trace(GetCallback(), " -> Triangulate Fills : %s\n", Utils::ToString(triangulateFills).c_str());
+		Utils::Trace(GetCallback(), " -> Path Tolerance : %.2f\n", pathTolerance);
         if (html)
         {
             Utils::Trace(GetCallback(), " -> HTML path : %s\n", htmlPath.c_str());
@@ -295,6 +354,7 @@ namespace PixiJS
         {
             Utils::Trace(GetCallback(), " -> Images path : %s\n", imagesPath.c_str());
             Utils::Trace(GetCallback(), " -> Export Images : %s\n", Utils::ToString(images).c_str());
+            Utils::Trace(GetCallback(), " -> Reuse Images : %s\n", Utils::ToString(reuseImages).c_str());
             if (spritesheets)
             {
                 Utils::Trace(GetCallback(), " -> Spritesheet size : %s\n", Utils::ToString(spritesheetSize).c_str());
@@ -311,6 +371,11 @@ namespace PixiJS
 		// Temporary
 		// return FCM_SUCCESS;
 
+		if (!m_publishWorker.get())
+		{
+			m_publishWorker.reset(new PublishWorker(GetCallback()));
+		}
+
 		std::auto_ptr<OutputWriter> outputWriter(new OutputWriter(GetCallback(),
 			basePath,
 			outputFile,
@@ -323,6 +388,7 @@ namespace PixiJS
 			html,
 			libs,
 			images,
+			reuseImages,
 			sounds,
 			compactShapes,
 			compressJS,
@@ -330,7 +396,12 @@ namespace PixiJS
 			loopTimeline,
 			spritesheets,
 			spritesheetSize,
-			spritesheetScale));
+			spritesheetScale,
+			tweenTolerance,
+			transformPrecision,
+			animationTracks,
+			triangulateFills,
+			m_publishWorker.get()));
 
 		if (outputWriter.get() == NULL)
 		{
@@ -356,7 +427,7 @@ namespace PixiJS
 
 		ResourcePalette* pResPalette = static_cast<ResourcePalette*>(m_pResourcePalette.m_Ptr);
 		pResPalette->Clear();
-		pResPalette->Init(outputWriter.get());
+		pResPalette->Init(outputWriter.get(), pathTolerance);
 
 		res = flaDocument->GetBackgroundColor(color);
 		ASSERT(FCM_SUCCESS_CODE(res));
@@ -375,6 +446,12 @@ namespace PixiJS
 		res = outputWriter->StartDocument(color, stageHeight, stageWidth, framesPerSec);
 		ASSERT(FCM_SUCCESS_CODE(res));
 
+		// Without them the tweens are only fitted to the frame commands
+		if (nativeTweens)
+		{
+			ExportTweenSpans(flaDocument, timeline, outputWriter.get());
+		}
+
 		// Export complete document ?
 		if (!timeline)
 		{
@@ -486,6 +563,10 @@ namespace PixiJS
 			ASSERT(FCM_SUCCESS_CODE(res));
 		}
 
+#ifdef _DEBUG
+		pResPalette->TraceStats();
+#endif
+
 		// Stop preview
 		outputWriter->StopPreview();
 
@@ -520,6 +601,11 @@ namespace PixiJS
 
 			pResPalette->Clear();
 		}
+
+		if (!m_outputFile.empty())
+		{
+			OutputWriter::RemoveCache(m_basePath, m_outputFile);
+		}
 		return FCM_SUCCESS;
 	}
 
@@ -633,6 +719,9 @@ namespace PixiJS
 			// Create a Resource Palette
 			res = GetCallback()->CreateInstance(NULL, CLSID_ResourcePalette, IID_IResourcePalette, (void**)&m_pResourcePalette);
 			ASSERT(FCM_SUCCESS_CODE(res));
+
+			res = static_cast<ResourcePalette*>(m_pResourcePalette.m_Ptr)->InitServices();
+			ASSERT(FCM_SUCCESS_CODE(res));
 		}
 
 		return res;
@@ -643,6 +732,248 @@ namespace PixiJS
 	// Note: This function is NOT completely implemented but provides guidelines 
 	// on how this can be possibly done.      
 	//
+	FCM::Result CPublisher::ExportTweenSpans(
+		DOM::PIFLADocument flaDocument,
+		DOM::PITimeline timeline,
+		OutputWriter* pOutputWriter)
+	{
+		FCM::Result res;
+		FCM::AutoPtr<FCM::IFCMUnknown> pUnk;
+
+		res = GetCallback()->GetService(DOM::Service::Tween::TWEENER_SERVICE, pUnk.m_Ptr);
+		if (FCM_FAILURE_CODE(res))
+		{
+			return res;
+		}
+
+		AutoPtr<DOM::Service::Tween::ITweenerService> pTweenerService = pUnk;
+		if (!pTweenerService)
+		{
+			return FCM_GENERAL_ERROR;
+		}
+
+		FCM::AutoPtr<FCM::IFCMUnknown> pGeometricTweener;
+		FCM::AutoPtr<FCM::IFCMUnknown> pColorTweener;
+		pTweenerService->GetTweener(DOM::Service::Tween::GEOMETRIC_PROPERTY_ID, NULL, pGeometricTweener.m_Ptr);
+		pTweenerService->GetTweener(DOM::Service::Tween::COLOR_PROPERTY_ID, NULL, pColorTweener.m_Ptr);
+		m_geometricTweener = pGeometricTweener;
+		m_colorTweener = pColorTweener;
+
+		// The stage is written with an empty name
+		TWEEN_SPAN_LIST spans;
+		if (timeline)
+		{
+			GetTweenSpans(timeline, spans);
+		}
+		else
+		{
+			FCM::FCMListPtr timelineList;
+			res = flaDocument->GetTimelines(timelineList.m_Ptr);
+			if (FCM_SUCCESS_CODE(res))
+			{
+				AutoPtr<DOM::ITimeline> stage = timelineList[0];
+				GetTweenSpans(stage, spans);
+			}
+		}
+		pOutputWriter->SetTweenSpans("", spans);
+
+		FCM::FCMListPtr pLibraryItemList;
+		res = flaDocument->GetLibraryItems(pLibraryItemList.m_Ptr);
+		if (FCM_SUCCESS_CODE(res))
+		{
+			res = ExportLibraryTweenSpans(pLibraryItemList, pOutputWriter);
+		}
+
+		m_geometricTweener.Reset();
+		m_colorTweener.Reset();
+
+		return res;
+	}
+
+
+	FCM::Result CPublisher::ExportLibraryTweenSpans(
+		FCM::FCMListPtr pLibraryItemList,
+		OutputWriter* pOutputWriter)
+	{
+		FCM::U_Int32 count = 0;
+		FCM::Result res;
+
+		res = pLibraryItemList->Count(count);
+		ASSERT(FCM_SUCCESS_CODE(res));
+
+		FCM::AutoPtr<FCM::IFCMCalloc> pCalloc = PixiJS::Utils::GetCallocService(GetCallback());
+		ASSERT(pCalloc.m_Ptr != NULL);
+
+		for (FCM::U_Int32 index = 0; index < count; index++)
+		{
+			AutoPtr<DOM::ILibraryItem> pLibItem = pLibraryItemList[index];
+
+			AutoPtr<DOM::LibraryItem::IFolderItem> pFolderItem = pLibItem;
+			if (pFolderItem)
+			{
+				FCM::FCMListPtr pChildren;
+
+				res = pFolderItem->GetChildren(pChildren.m_Ptr);
+				ASSERT(FCM_SUCCESS_CODE(res));
+
+				ExportLibraryTweenSpans(pChildren, pOutputWriter);
+				continue;
+			}
+
+			AutoPtr<DOM::LibraryItem::ISymbolItem> pSymbolItem = pLibItem;
+			if (!pSymbolItem)
+			{
+				continue;
+			}
+
+			AutoPtr<DOM::ITimeline> pTimeline;
+			res = pSymbolItem->GetTimeLine(pTimeline.m_Ptr);
+			if (FCM_FAILURE_CODE(res) || !pTimeline)
+			{
+				continue;
+			}
+
+			TWEEN_SPAN_LIST spans;
+			GetTweenSpans(pTimeline, spans);
+			if (spans.empty())
+			{
+				continue;
+			}
+
+			// Symbols are defined under their library item name
+			FCM::StringRep16 pLibItemName = NULL;
+			res = pLibItem->GetName(&pLibItemName);
+			ASSERT(FCM_SUCCESS_CODE(res));
+
+			pOutputWriter->SetTweenSpans(Utils::ToString(pLibItemName, GetCallback()), spans);
+			pCalloc->Free(pLibItemName);
+		}
+
+		return FCM_SUCCESS;
+	}
+
+
+	void CPublisher::GetTweenSpans(DOM::PITimeline timeline, TWEEN_SPAN_LIST& spans)
+	{
+		FCM::FCMListPtr pLayerList;
+
+		if (FCM_SUCCESS_CODE(timeline->GetLayers(pLayerList.m_Ptr)))
+		{
+			GetLayerTweenSpans(pLayerList, spans);
+		}
+	}
+
+
+	void CPublisher::GetLayerTweenSpans(FCM::FCMListPtr pLayerList, TWEEN_SPAN_LIST& spans)
+	{
+		FCM::U_Int32 layerCount = 0;
+		pLayerList->Count(layerCount);
+
+		for (FCM::U_Int32 i = 0; i < layerCount; i++)
+		{
+			AutoPtr<DOM::ILayer> pLayer = pLayerList[i];
+			FCM::AutoPtr<FCM::IFCMUnknown> pLayerType;
+			if (!pLayer || FCM_FAILURE_CODE(pLayer->GetLayerType(pLayerType.m_Ptr)))
+			{
+				continue;
+			}
+
+			// Folders, masks and guides hold the layers under them
+			FCM::FCMListPtr pChildren;
+			AutoPtr<DOM::Layer::ILayerFolder> pFolder = pLayerType;
+			AutoPtr<DOM::Layer::ILayerMask> pMask = pLayerType;
+			AutoPtr<DOM::Layer::ILayerGuide> pGuide = pLayerType;
+			if (pFolder)
+			{
+				pFolder->GetChildren(pChildren.m_Ptr);
+			}
+			else if (pMask)
+			{
+				pMask->GetChildren(pChildren.m_Ptr);
+			}
+			else if (pGuide)
+			{
+				pGuide->GetChildren(pChildren.m_Ptr);
+			}
+			if (pChildren)
+			{
+				GetLayerTweenSpans(pChildren, spans);
+				continue;
+			}
+
+			AutoPtr<DOM::Layer::ILayerNormal> pNormal = pLayerType;
+			FCM::FCMListPtr pKeyFrames;
+			if (!pNormal || FCM_FAILURE_CODE(pNormal->GetKeyFrames(pKeyFrames.m_Ptr)))
+			{
+				continue;
+			}
+
+			FCM::U_Int32 frameCount = 0;
+			pKeyFrames->Count(frameCount);
+
+			for (FCM::U_Int32 j = 0; j < frameCount; j++)
+			{
+				AutoPtr<DOM::IFrame> pFrame = pKeyFrames[j];
+				AutoPtr<DOM::ITween> pTween;
+				if (!pFrame || FCM_FAILURE_CODE(pFrame->GetTween(pTween.m_Ptr)) || !pTween)
+				{
+					continue;
+				}
+
+				TWEEN_SPAN span;
+				pFrame->GetStartFrameIndex(span.frame);
+				pFrame->GetDuration(span.duration);
+				if (span.duration < 2)
+				{
+					continue;
+				}
+
+				FCM::AutoPtr<FCM::IFCMDictionary> pProperties;
+				if (FCM_FAILURE_CODE(pTween->GetTweenedProperties(pProperties.m_Ptr)) || !pProperties)
+				{
+					continue;
+				}
+
+				// The first two frames are enough to tell which instance it moves
+				FCM::U_Int32 samples = span.duration > 2 ? 2 : 1;
+				FCM::FCMDictRecTypeID type;
+				FCM::U_Int32 valLen;
+
+				if (m_geometricTweener &&
+					FCM_SUCCESS_CODE(pProperties->GetInfo((FCM::StringRep8)kDOMGeometricProperty, type, valLen)))
+				{
+					for (FCM::U_Int32 k = 0; k < samples; k++)
+					{
+						DOM::Utils::MATRIX2D matrix;
+						if (FCM_SUCCESS_CODE(m_geometricTweener->GetGeometricTransform(pTween, k, matrix)))
+						{
+							span.matrices.push_back(matrix);
+						}
+					}
+				}
+
+				if (m_colorTweener &&
+					FCM_SUCCESS_CODE(pProperties->GetInfo((FCM::StringRep8)kDOMColorProperty, type, valLen)))
+				{
+					for (FCM::U_Int32 k = 0; k < samples; k++)
+					{
+						DOM::Utils::COLOR_MATRIX color;
+						if (FCM_SUCCESS_CODE(m_colorTweener->GetColorMatrix(pTween, k, color)))
+						{
+							span.colors.push_back(color);
+						}
+					}
+				}
+
+				if (!span.matrices.empty() || !span.colors.empty())
+				{
+					spans.push_back(span);
+				}
+			}
+		}
+	}
+
+
 	FCM::Result CPublisher::ExportLibraryItems(FCM::FCMListPtr pLibraryItemList)
 	{
 		FCM::U_Int32 count = 0;
@@ -783,11 +1114,11 @@ namespace PixiJS
 
 		LOG(("[EndSymbol] ResId: %d\n", resourceId));
 
-		m_resourceList.push_back(resourceId);
+		AddResource(resourceId);
 
 		if (pName != NULL)
 		{
-			m_resourceNames.push_back(Utils::ToString(pName, GetCallback()));
+			AddResourceName(Utils::ToString(pName, GetCallback()));
 		}
 
 		TimelineBuilder* timeline = static_cast<TimelineBuilder*>(timelineBuilder);
@@ -806,14 +1137,29 @@ namespace PixiJS
 
 		LOG(("[DefineShape] ResId: %d\n", resourceId));
 
-		m_resourceList.push_back(resourceId);
+#ifdef _DEBUG
+		std::clock_t start = std::clock();
+#endif
+		AddResource(resourceId);
 		m_outputWriter->StartDefineShape();
 
 		if (pShape)
 		{
 			ExportFill(pShape);
 
-			res = HasFancyStrokes(pShape, hasFancy);
+			// Fetched once, both to check for fancy strokes and to export them
+			FCM::FCMListPtr pStrokeGroupList;
+#ifdef _DEBUG
+			std::clock_t regionStart = std::clock();
+#endif
+			res = m_regionGeneratorService->GetStrokeGroups(pShape, pStrokeGroupList.m_Ptr);
+			ASSERT(FCM_SUCCESS_CODE(res));
+#ifdef _DEBUG
+			m_regionTime += (FCM::Double)(std::clock() - regionStart) / CLOCKS_PER_SEC;
+			m_regionCalls++;
+#endif
+
+			res = HasFancyStrokes(pStrokeGroupList, hasFancy);
 			if (hasFancy)
 			{
 				res = ConvertStrokeToFill(pShape, pNewShape.m_Ptr);
@@ -823,12 +1169,15 @@ namespace PixiJS
 			}
 			else
 			{
-
-				ExportStroke(pShape);
+				ExportStroke(pStrokeGroupList);
 			}
 		}
 
 		m_outputWriter->EndDefineShape(resourceId);
+#ifdef _DEBUG
+		m_shapeTime += (FCM::Double)(std::clock() - start) / CLOCKS_PER_SEC;
+		m_shapeCount++;
+#endif
 
 		return FCM_SUCCESS;
 	}
@@ -844,7 +1193,7 @@ namespace PixiJS
 
 		LOG(("[DefineSound] ResId: %d\n", resourceId));
 
-		m_resourceList.push_back(resourceId);
+		AddResource(resourceId);
 
 		// Store the resource name
 		pLibItem = pMediaItem;
@@ -852,7 +1201,7 @@ namespace PixiJS
 		res = pLibItem->GetName(&pName);
 		ASSERT(FCM_SUCCESS_CODE(res));
 		libName = Utils::ToString(pName, GetCallback());
-		m_resourceNames.push_back(libName);
+		AddResourceName(libName);
 
 		res = pMediaItem->GetMediaInfo(pUnknown.m_Ptr);
 		ASSERT(FCM_SUCCESS_CODE(res));
@@ -881,7 +1230,7 @@ namespace PixiJS
 
 		LOG(("[DefineBitmap] ResId: %d\n", resourceId));
 
-		m_resourceList.push_back(resourceId);
+		AddResource(resourceId);
 
 		pLibItem = pMediaItem;
 
@@ -889,7 +1238,7 @@ namespace PixiJS
 		res = pLibItem->GetName(&pName);
 		ASSERT(FCM_SUCCESS_CODE(res));
 		std::string libItemName = Utils::ToString(pName, GetCallback());
-		m_resourceNames.push_back(libItemName);
+		AddResourceName(libItemName);
 
 		AutoPtr<FCM::IFCMUnknown> medInfo;
 		pMediaItem->GetMediaInfo(medInfo.m_Ptr);
@@ -1039,17 +1388,7 @@ namespace PixiJS
 
 	FCM::Result ResourcePalette::HasResource(FCM::U_Int32 resourceId, FCM::Boolean& hasResource)
 	{
-		hasResource = false;
-
-		for (std::vector<FCM::U_Int32>::iterator listIter = m_resourceList.begin();
-			listIter != m_resourceList.end(); listIter++)
-		{
-			if (*listIter == resourceId)
-			{
-				hasResource = true;
-				break;
-			}
-		}
+		hasResource = m_resourceIds.Contains(resourceId);
 
 		//LOG(("[HasResource] ResId: %d HasResource: %d\n", resourceId, hasResource));
 
@@ -1057,9 +1396,64 @@ namespace PixiJS
 	}
 
 
+	static const DOM::Utils::POINT2D& SegmentStart(const DOM::Utils::SEGMENT& segment)
+	{
+		return segment.segmentType == DOM::Utils::LINE_SEGMENT ?
+			segment.line.endPoint1 : segment.quadBezierCurve.anchor1;
+	}
+
+	static const DOM::Utils::POINT2D& SegmentEnd(const DOM::Utils::SEGMENT& segment)
+	{
+		return segment.segmentType == DOM::Utils::LINE_SEGMENT ?
+			segment.line.endPoint2 : segment.quadBezierCurve.anchor2;
+	}
+
+	static bool PointsEqual(const DOM::Utils::POINT2D& a, const DOM::Utils::POINT2D& b)
+	{
+		return a.x == b.x && a.y == b.y;
+	}
+
+	// Points written to the path data, the start point plus one per line and two per curve
+	static FCM::U_Int32 CountPathPoints(const std::vector<DOM::Utils::SEGMENT>& segments)
+	{
+		FCM::U_Int32 count = segments.empty() ? 0 : 1;
+		for (size_t i = 0; i < segments.size(); i++)
+		{
+			count += segments[i].segmentType == DOM::Utils::LINE_SEGMENT ? 1 : 2;
+		}
+		return count;
+	}
+
+	// Distance from p to the segment from a to b
+	static double PointToSegmentDistance(const DOM::Utils::POINT2D& p, const DOM::Utils::POINT2D& a, const DOM::Utils::POINT2D& b)
+	{
+		double dx = (double)b.x - a.x;
+		double dy = (double)b.y - a.y;
+		double lengthSq = dx * dx + dy * dy;
+		double t = 0;
+		if (lengthSq > 0)
+		{
+			t = (((double)p.x - a.x) * dx + ((double)p.y - a.y) * dy) / lengthSq;
+			t = t < 0 ? 0 : (t > 1 ? 1 : t);
+		}
+		double x = a.x + t * dx - p.x;
+		double y = a.y + t * dy - p.y;
+		return sqrt(x * x + y * y);
+	}
+
+
 	ResourcePalette::ResourcePalette()
 	{
 		m_outputWriter = NULL;
+		m_shapeCount = 0;
+		m_regionCalls = 0;
+		m_shapeTime = 0;
+		m_regionTime = 0;
+		m_convertTime = 0;
+		m_pathTolerance = 0;
+		m_runSlack = 0;
+		m_pathPointsIn = 0;
+		m_pathPointsOut = 0;
 	}
 
 
@@ -1068,29 +1462,81 @@ namespace PixiJS
 	}
 
 
-	void ResourcePalette::Init(IOutputWriter* outputWriter)
+	void ResourcePalette::Init(IOutputWriter* outputWriter, double pathTolerance)
 	{
 		m_outputWriter = outputWriter;
+		m_pathTolerance = pathTolerance;
+		m_pathPointsIn = 0;
+		m_pathPointsOut = 0;
 	}
 
 	void ResourcePalette::Clear()
 	{
-		m_resourceList.clear();
+		m_resourceIds.Clear();
+		m_resourceNames.clear();
+		m_shapeCount = 0;
+		m_regionCalls = 0;
+		m_shapeTime = 0;
+		m_regionTime = 0;
+		m_convertTime = 0;
+		m_pathPointsIn = 0;
+		m_pathPointsOut = 0;
+	}
+
+	FCM::Result ResourcePalette::InitServices()
+	{
+		FCM::Result res;
+		FCM::AutoPtr<FCM::IFCMUnknown> pUnkRegion;
+		FCM::AutoPtr<FCM::IFCMUnknown> pUnkShape;
+
+		res = GetCallback()->GetService(DOM::FLA_REGION_GENERATOR_SERVICE, pUnkRegion.m_Ptr);
+		if (FCM_FAILURE_CODE(res))
+		{
+			return res;
+		}
+		m_regionGeneratorService = pUnkRegion;
+
+		res = GetCallback()->GetService(DOM::FLA_SHAPE_SERVICE, pUnkShape.m_Ptr);
+		if (FCM_FAILURE_CODE(res))
+		{
+			return res;
+		}
+		m_shapeService = pUnkShape;
+
+		if (!m_regionGeneratorService || !m_shapeService)
+		{
+			return FCM_GENERAL_ERROR;
+		}
+		return FCM_SUCCESS;
+	}
+
+	void ResourcePalette::TraceStats()
+	{
+		Utils::Trace(GetCallback(), "Shapes: %u in %.3fs, %u region generator calls in %.3fs, %.3fs converting strokes\n",
+			m_shapeCount, m_shapeTime, m_regionCalls, m_regionTime, m_convertTime);
+
+		if (m_pathTolerance > 0)
+		{
+			Utils::Trace(GetCallback(), "Path points: %u before simplification, %u after\n",
+				m_pathPointsIn, m_pathPointsOut);
+		}
+	}
+
+	void ResourcePalette::AddResource(FCM::U_Int32 resourceId)
+	{
+		m_resourceIds.Insert(resourceId);
+	}
+
+	void ResourcePalette::AddResourceName(const std::string& name)
+	{
+		m_resourceNames.insert(name);
 	}
 
 	FCM::Result ResourcePalette::HasResource(
 		const std::string& name,
 		FCM::Boolean& hasResource)
 	{
-		hasResource = false;
-		for (FCM::U_Int32 index = 0; index < m_resourceNames.size(); index++)
-		{
-			if (m_resourceNames[index] == name)
-			{
-				hasResource = true;
-				break;
-			}
-		}
+		hasResource = m_resourceNames.find(name) != m_resourceNames.end();
 
 		return FCM_SUCCESS;
 	}
@@ -1100,15 +1546,25 @@ namespace PixiJS
 	{
 		FCM::Result res;
 		FCM::FCMListPtr pFilledRegionList;
-		FCM::AutoPtr<FCM::IFCMUnknown> pUnkSRVReg;
-		FCM::U_Int32 regionCount;
 
-		GetCallback()->GetService(DOM::FLA_REGION_GENERATOR_SERVICE, pUnkSRVReg.m_Ptr);
-		AutoPtr<DOM::Service::Shape::IRegionGeneratorService> pIRegionGeneratorService(pUnkSRVReg);
-		ASSERT(pIRegionGeneratorService);
-
-		res = pIRegionGeneratorService->GetFilledRegions(pIShape, pFilledRegionList.m_Ptr);
+#ifdef _DEBUG
+		std::clock_t start = std::clock();
+#endif
+		res = m_regionGeneratorService->GetFilledRegions(pIShape, pFilledRegionList.m_Ptr);
 		ASSERT(FCM_SUCCESS_CODE(res));
+#ifdef _DEBUG
+		m_regionTime += (FCM::Double)(std::clock() - start) / CLOCKS_PER_SEC;
+		m_regionCalls++;
+#endif
+
+		return ExportFill(pFilledRegionList);
+	}
+
+
+	FCM::Result ResourcePalette::ExportFill(FCM::FCMListPtr pFilledRegionList)
+	{
+		FCM::Result res = FCM_SUCCESS;
+		FCM::U_Int32 regionCount;
 
 		pFilledRegionList->Count(regionCount);
 
@@ -1201,22 +1657,147 @@ namespace PixiJS
 		res = pEdgeList->Count(edgeCount);
 		ASSERT(FCM_SUCCESS_CODE(res));
 
+		m_segments.resize(edgeCount);
 		for (FCM::U_Int32 l = 0; l < edgeCount; l++)
 		{
-			DOM::Utils::SEGMENT segment;
+			DOM::Utils::SEGMENT& segment = m_segments[l];
 
 			segment.structSize = sizeof(DOM::Utils::SEGMENT);
 
 			FCM::AutoPtr<DOM::Service::Shape::IEdge> pEdge = pEdgeList[l];
 
 			res = pEdge->GetSegment(segment);
+		}
 
-			m_outputWriter->SetSegment(segment);
+		m_pathPointsIn += CountPathPoints(m_segments);
+		if (m_pathTolerance > 0)
+		{
+			SimplifyPath(m_segments);
+		}
+		m_pathPointsOut += CountPathPoints(m_segments);
+
+		for (size_t i = 0; i < m_segments.size(); i++)
+		{
+			m_outputWriter->SetSegment(m_segments[i]);
 		}
 
 		return res;
 	}
 
+	void ResourcePalette::SimplifyPath(std::vector<DOM::Utils::SEGMENT>& segments)
+	{
+		if (segments.empty())
+		{
+			return;
+		}
+
+		m_simplified.clear();
+		m_runPoints.clear();
+		m_runSlack = 0;
+
+		// Lines are gathered into runs of points and thinned when a curve or the end breaks the run
+		m_runPoints.push_back(SegmentStart(segments[0]));
+
+		for (size_t i = 0; i < segments.size(); i++)
+		{
+			const DOM::Utils::SEGMENT& segment = segments[i];
+
+			if (segment.segmentType == DOM::Utils::QUAD_BEZIER_SEGMENT)
+			{
+				const DOM::Utils::QUAD_BEZIER_CURVE& curve = segment.quadBezierCurve;
+
+				// A curve strays at most half its control point's distance from the chord,
+				// measured to the segment so curves that overshoot an end aren't folded
+				double deviation = PointToSegmentDistance(curve.control, curve.anchor1, curve.anchor2) * 0.5;
+				if (deviation > m_pathTolerance)
+				{
+					FlushLineRun();
+					m_simplified.push_back(segment);
+					m_runPoints.push_back(curve.anchor2);
+					continue;
+				}
+				// The rest of the run gets what the flattened curve didn't use
+				m_runSlack = std::max(m_runSlack, deviation);
+			}
+			m_runPoints.push_back(SegmentEnd(segment));
+		}
+		FlushLineRun();
+
+		// Too little left of a closed path to enclose anything, leave it as drawn
+		bool closed = PointsEqual(SegmentStart(segments.front()), SegmentEnd(segments.back()));
+		if (m_simplified.empty() || (closed && m_simplified.size() < 3))
+		{
+			return;
+		}
+		segments.swap(m_simplified);
+	}
+
+	void ResourcePalette::FlushLineRun()
+	{
+		size_t count = m_runPoints.size();
+		double tolerance = m_pathTolerance - m_runSlack;
+
+		if (count > 2)
+		{
+			// Douglas-Peucker with an explicit stack, keeping the ends of the run
+			m_keepPoints.assign(count, false);
+			m_keepPoints[0] = true;
+			m_keepPoints[count - 1] = true;
+
+			std::vector<std::pair<size_t, size_t> > ranges;
+			ranges.push_back(std::make_pair((size_t)0, count - 1));
+
+			while (!ranges.empty())
+			{
+				size_t first = ranges.back().first;
+				size_t last = ranges.back().second;
+				ranges.pop_back();
+
+				double maxDistance = 0;
+				size_t farthest = first;
+				for (size_t i = first + 1; i < last; i++)
+				{
+					double distance = PointToSegmentDistance(m_runPoints[i], m_runPoints[first], m_runPoints[last]);
+					if (distance > maxDistance)
+					{
+						maxDistance = distance;
+						farthest = i;
+					}
+				}
+
+				if (maxDistance > tolerance)
+				{
+					m_keepPoints[farthest] = true;
+					ranges.push_back(std::make_pair(first, farthest));
+					ranges.push_back(std::make_pair(farthest, last));
+				}
+			}
+		}
+
+		// Write the kept points out as lines, dropping any of zero length
+		size_t previous = 0;
+		for (size_t i = 1; i < count; i++)
+		{
+			if (count > 2 && !m_keepPoints[i])
+			{
+				continue;
+			}
+			if (!PointsEqual(m_runPoints[previous], m_runPoints[i]))
+			{
+				DOM::Utils::SEGMENT line;
+				line.structSize = sizeof(DOM::Utils::SEGMENT);
+				line.segmentType = DOM::Utils::LINE_SEGMENT;
+				line.line.endPoint1 = m_runPoints[previous];
+				line.line.endPoint2 = m_runPoints[i];
+				m_simplified.push_back(line);
+			}
+			previous = i;
+		}
+
+		m_runPoints.clear();
+		m_runSlack = 0;
+	}
+
 	FCM::Result ResourcePalette::ExportFillStyle(FCM::PIFCMUnknown pFillStyle)
 	{
 		FCM::Result res = FCM_SUCCESS;
@@ -1239,7 +1820,6 @@ namespace PixiJS
 
 		if (pGradientFillStyle)
 		{
-			Utils::Trace(GetCallback(), "Warning: Gradient fills are not supported by Pixi.js\n");
 			pGradientFillStyle->GetColorGradient(pGrad.m_Ptr);
 
 			if (AutoPtr<DOM::Utils::IRadialColorGradient>(pGrad))
@@ -1257,7 +1837,6 @@ namespace PixiJS
 		pBitmapFillStyle = pFillStyle;
 		if (pBitmapFillStyle)
 		{
-			Utils::Trace(GetCallback(), "Warning: Bitmap fills are not supported by Pixi.js\n");
 			res = ExportBitmapFillStyle(pBitmapFillStyle);
 			ASSERT(FCM_SUCCESS_CODE(res));
 		}
@@ -1266,20 +1845,11 @@ namespace PixiJS
 	}
 
 
-	FCM::Result ResourcePalette::ExportStroke(DOM::FrameElement::PIShape pIShape)
+	FCM::Result ResourcePalette::ExportStroke(FCM::FCMListPtr pStrokeGroupList)
 	{
-		FCM::FCMListPtr pStrokeGroupList;
 		FCM::U_Int32 strokeStyleCount;
 		FCM::Result res;
 
-		FCM::AutoPtr<FCM::IFCMUnknown> pUnkSRVReg;
-		GetCallback()->GetService(DOM::FLA_REGION_GENERATOR_SERVICE, pUnkSRVReg.m_Ptr);
-		AutoPtr<DOM::Service::Shape::IRegionGeneratorService> pIRegionGeneratorService(pUnkSRVReg);
-		ASSERT(pIRegionGeneratorService);
-
-		res = pIRegionGeneratorService->GetStrokeGroups(pIShape, pStrokeGroupList.m_Ptr);
-		ASSERT(FCM_SUCCESS_CODE(res));
-
 		res = pStrokeGroupList->Count(strokeStyleCount);
 		ASSERT(FCM_SUCCESS_CODE(res));
 
@@ -1338,22 +1908,13 @@ namespace PixiJS
 	}
 
 
-	FCM::Result ResourcePalette::HasFancyStrokes(DOM::FrameElement::PIShape pShape, FCM::Boolean& hasFancy)
+	FCM::Result ResourcePalette::HasFancyStrokes(FCM::FCMListPtr pStrokeGroupList, FCM::Boolean& hasFancy)
 	{
 		FCM::Result res;
-		FCM::FCMListPtr pStrokeGroupList;
 		FCM::U_Int32 strokeStyleCount;
 
 		hasFancy = false;
 
-		FCM::AutoPtr<FCM::IFCMUnknown> pUnkSRVReg;
-		GetCallback()->GetService(DOM::FLA_REGION_GENERATOR_SERVICE, pUnkSRVReg.m_Ptr);
-		AutoPtr<DOM::Service::Shape::IRegionGeneratorService> pIRegionGeneratorService(pUnkSRVReg);
-		ASSERT(pIRegionGeneratorService);
-
-		res = pIRegionGeneratorService->GetStrokeGroups(pShape, pStrokeGroupList.m_Ptr);
-		ASSERT(FCM_SUCCESS_CODE(res));
-
 		res = pStrokeGroupList->Count(strokeStyleCount);
 		ASSERT(FCM_SUCCESS_CODE(res));
 
@@ -1400,15 +1961,15 @@ namespace PixiJS
 		DOM::FrameElement::PIShape& pNewShape)
 	{
 		FCM::Result res;
-		FCM::AutoPtr<FCM::IFCMUnknown> pUnkSRVReg;
-
-		GetCallback()->GetService(DOM::FLA_SHAPE_SERVICE, pUnkSRVReg.m_Ptr);
-
-		AutoPtr<DOM::Service::Shape::IShapeService> pIShapeService(pUnkSRVReg);
-		ASSERT(pIShapeService);
 
-		res = pIShapeService->ConvertStrokeToFill(pShape, pNewShape);
+#ifdef _DEBUG
+		std::clock_t start = std::clock();
+#endif
+		res = m_shapeService->ConvertStrokeToFill(pShape, pNewShape);
 		ASSERT(FCM_SUCCESS_CODE(res));
+#ifdef _DEBUG
+		m_convertTime += (FCM::Double)(std::clock() - start) / CLOCKS_PER_SEC;
+#endif
 
 		return FCM_SUCCESS;
 	}
@@ -1637,7 +2198,7 @@ namespace PixiJS
 		res = pLibItem->GetName(&pName);
 		ASSERT(FCM_SUCCESS_CODE(res));
 		std::string libItemName = Utils::ToString(pName, GetCallback());
-		m_resourceNames.push_back(libItemName);
+		AddResourceName(libItemName);
 
 		// Get image width
 		FCM::S_Int32 width;
@@ -2167,7 +2728,10 @@ namespace PixiJS
 
 		m_outputWriter->StartDefineTimeline();
 
-		m_timelineWriter = new TimelineWriter(GetCallback());
+		OutputWriter* pOutputWriter = static_cast<OutputWriter*>(m_outputWriter);
+		m_timelineWriter = new TimelineWriter(GetCallback(),
+			pOutputWriter->GetTransformPrecision(),
+			pOutputWriter->GetAnimationTracks());
 		ASSERT(m_timelineWriter);
 	}
 
@@ -0,0 +1,53 @@
+//
+//  ResourceIdSet.cpp
+//  PixiAnimate.mp
+//
+
+#include "ResourceIdSet.h"
+
+#include <algorithm>
+
+namespace PixiJS
+{
+	const FCM::U_Int32 ResourceIdSet::MAX_DIRECT_ID;
+
+	ResourceIdSet::ResourceIdSet()
+	{
+	}
+
+	ResourceIdSet::~ResourceIdSet()
+	{
+	}
+
+	void ResourceIdSet::Insert(FCM::U_Int32 id)
+	{
+		if (id >= MAX_DIRECT_ID)
+		{
+			m_sparse.insert(id);
+			return;
+		}
+
+		if (id >= m_direct.size())
+		{
+			// Grow geometrically so a long run of new ids stays amortized O(1)
+			size_t size = std::max<size_t>(id + 1, m_direct.size() * 2);
+			m_direct.resize(std::min<size_t>(size, MAX_DIRECT_ID), false);
+		}
+		m_direct[id] = true;
+	}
+
+	bool ResourceIdSet::Contains(FCM::U_Int32 id) const
+	{
+		if (id < m_direct.size())
+		{
+			return m_direct[id];
+		}
+		return id >= MAX_DIRECT_ID && m_sparse.find(id) != m_sparse.end();
+	}
+
+	void ResourceIdSet::Clear()
+	{
+		m_direct.clear();
+		m_sparse.clear();
+	}
+};
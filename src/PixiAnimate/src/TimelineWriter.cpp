@@ -22,9 +22,385 @@
 #include "GraphicFilter/IGradientBevelFilter.h"
 #include "GraphicFilter/IGradientGlowFilter.h"
 #include "Utils/ILinearColorGradient.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <set>
 
 namespace PixiJS
 {
+	// Transforms are tweened as x, y, scaleX, scaleY, skewX and skewY
+	static const int TRANSFORM_CHANNELS = 6;
+
+	// Colors are tweened as the multiplier and offset of r, g, b and a
+	static const int COLOR_CHANNELS = 8;
+
+	static const int MAX_TWEEN_CHANNELS = 8;
+
+	// Scale and skew errors are measured this many pixels from the registration point
+	static const double TWEEN_RADIUS = 100.0;
+
+	// Keeps exact tweens from failing on rounding
+	static const double TWEEN_EPSILON = 0.000001;
+
+	// Color tweens stay within a step of 255
+	static const double COLOR_TOLERANCE = 0.5 / 255.0;
+
+	// How close an instance must be to the start of a keyframe tween to own it
+	static const double TWEEN_MATCH_TOLERANCE = 0.01;
+	static const double COLOR_MATCH_TOLERANCE = 1.0 / 255.0;
+
+	static const double TWEEN_PI = 3.14159265358979323846;
+
+	static void DecomposeTransform(const DOM::Utils::MATRIX2D& matrix, double* channels)
+	{
+		channels[0] = matrix.tx;
+		channels[1] = matrix.ty;
+		channels[2] = sqrt(matrix.a * matrix.a + matrix.b * matrix.b);
+		channels[3] = sqrt(matrix.c * matrix.c + matrix.d * matrix.d);
+		channels[4] = atan2(matrix.d, matrix.c);
+		channels[5] = atan2(matrix.b, matrix.a);
+	}
+
+	static void ComposeTransform(const double* channels, DOM::Utils::MATRIX2D& matrix)
+	{
+		matrix.tx = (FCM::Float)channels[0];
+		matrix.ty = (FCM::Float)channels[1];
+		matrix.a = (FCM::Float)(channels[2] * cos(channels[5]));
+		matrix.b = (FCM::Float)(channels[2] * sin(channels[5]));
+		matrix.c = (FCM::Float)(channels[3] * cos(channels[4]));
+		matrix.d = (FCM::Float)(channels[3] * sin(channels[4]));
+	}
+
+	// Same order and units as Utils::ToJSON writes a color matrix
+	static void DecomposeColor(const DOM::Utils::COLOR_MATRIX& color, double* channels)
+	{
+		for (int i = 0; i < 4; i++)
+		{
+			channels[i * 2] = color.matrix[i][i];
+			channels[i * 2 + 1] = color.matrix[i][4] / 255;
+		}
+	}
+
+	// How far, in pixels, a point near the instance can land between the two transforms
+	static double TransformError(const DOM::Utils::MATRIX2D& a, const DOM::Utils::MATRIX2D& b)
+	{
+		double x = fabs(a.tx - b.tx) + TWEEN_RADIUS * (fabs(a.a - b.a) + fabs(a.c - b.c));
+		double y = fabs(a.ty - b.ty) + TWEEN_RADIUS * (fabs(a.b - b.b) + fabs(a.d - b.d));
+		return x > y ? x : y;
+	}
+
+	static double TransformChannelError(const double* tween, const double* key)
+	{
+		DOM::Utils::MATRIX2D a;
+		DOM::Utils::MATRIX2D b;
+		ComposeTransform(tween, a);
+		ComposeTransform(key, b);
+		return TransformError(a, b);
+	}
+
+	static double ColorChannelError(const double* tween, const double* key)
+	{
+		double error = 0.0;
+		for (int c = 0; c < COLOR_CHANNELS; c++)
+		{
+			double diff = fabs(tween[c] - key[c]);
+			error = diff > error ? diff : error;
+		}
+		return error;
+	}
+
+	static double ColorError(const DOM::Utils::COLOR_MATRIX& a, const DOM::Utils::COLOR_MATRIX& b)
+	{
+		double channelsA[COLOR_CHANNELS];
+		double channelsB[COLOR_CHANNELS];
+		DecomposeColor(a, channelsA);
+		DecomposeColor(b, channelsB);
+		return ColorChannelError(channelsA, channelsB);
+	}
+
+	// How keys of one kind are tweened and compared
+	struct TWEEN_MODEL
+	{
+		int channels;
+
+		// Scale of each channel when fitting the ease
+		double weights[MAX_TWEEN_CHANNELS];
+
+		double (*error)(const double* tween, const double* key);
+	};
+
+	static const TWEEN_MODEL TRANSFORM_MODEL = {
+		TRANSFORM_CHANNELS,
+		{ 1.0, 1.0, TWEEN_RADIUS, TWEEN_RADIUS, TWEEN_RADIUS, TWEEN_RADIUS },
+		TransformChannelError
+	};
+
+	static const TWEEN_MODEL COLOR_MODEL = {
+		COLOR_CHANNELS,
+		{ 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0, 1.0 },
+		ColorChannelError
+	};
+
+	// Classic tween easing, -100 eases in and 100 eases out
+	static double EaseTween(double t, int ease)
+	{
+		return t + ease / 100.0 * t * (1.0 - t);
+	}
+
+	// Check that the keys between first and last are within tolerance of a
+	// tween from first to last, fitting the ease on the way
+	static bool FitTween(
+		const std::vector<double>& channels,
+		const TWEEN_MODEL& model,
+		size_t first,
+		size_t last,
+		double tolerance,
+		int& ease)
+	{
+		const int count = model.channels;
+		const double* from = &channels[first * count];
+		const double* to = &channels[last * count];
+		double duration = (double)(last - first);
+
+		// Least squares fit of the ease to the keys in between
+		double num = 0.0;
+		double den = 0.0;
+		for (size_t k = first + 1; k < last; k++)
+		{
+			double t = (k - first) / duration;
+			double curve = t * (1.0 - t);
+			for (int c = 0; c < count; c++)
+			{
+				double delta = (to[c] - from[c]) * model.weights[c];
+				double residual = (channels[k * count + c] - from[c]) * model.weights[c] - delta * t;
+				num += residual * delta * curve;
+				den += delta * curve * delta * curve;
+			}
+		}
+
+		double amount = den > 0.0 ? num / den : 0.0;
+		amount = amount < -1.0 ? -1.0 : (amount > 1.0 ? 1.0 : amount);
+		ease = (int)floor(amount * 100.0 + 0.5);
+
+		double tween[MAX_TWEEN_CHANNELS];
+		for (size_t k = first + 1; k < last; k++)
+		{
+			double e = EaseTween((k - first) / duration, ease);
+			for (int c = 0; c < count; c++)
+			{
+				tween[c] = from[c] + (to[c] - from[c]) * e;
+			}
+
+			if (model.error(tween, &channels[k * count]) > tolerance + TWEEN_EPSILON)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// The furthest key, up to limit, a tween from first can reach.
+	// Limit is tried first when it ends a keyframe tween.
+	static size_t FitSegment(
+		const std::vector<double>& channels,
+		const TWEEN_MODEL& model,
+		size_t first,
+		size_t limit,
+		bool keyframe,
+		double tolerance,
+		int& ease)
+	{
+		ease = 0;
+		if (limit - first < 2)
+		{
+			return limit;
+		}
+
+		if (keyframe && FitTween(channels, model, first, limit, tolerance, ease))
+		{
+			return limit;
+		}
+
+		// Double the span until it stops fitting, then narrow down the longest that fits
+		size_t good = first + 1;
+		size_t bad = limit;
+		int goodEase = 0;
+		int spanEase = 0;
+		for (size_t span = 2; first + span < limit; span *= 2)
+		{
+			if (!FitTween(channels, model, first, first + span, tolerance, spanEase))
+			{
+				bad = first + span;
+				break;
+			}
+			good = first + span;
+			goodEase = spanEase;
+		}
+		while (bad - good > 1)
+		{
+			size_t mid = good + (bad - good) / 2;
+			if (FitTween(channels, model, first, mid, tolerance, spanEase))
+			{
+				good = mid;
+				goodEase = spanEase;
+			}
+			else
+			{
+				bad = mid;
+			}
+		}
+
+		ease = goodEase;
+		return good;
+	}
+
+	static JSONNode ToTweenJSON(
+		const char* type,
+		FCM::U_Int32 objectId,
+		const std::vector<double>& channels,
+		int count,
+		size_t first,
+		size_t last,
+		int ease)
+	{
+		JSONNode commandElement(JSON_NODE);
+		JSONNode from(JSON_ARRAY);
+		JSONNode to(JSON_ARRAY);
+		from.set_name("from");
+		to.set_name("to");
+		for (int c = 0; c < count; c++)
+		{
+			from.push_back(JSONNode("", channels[first * count + c]));
+			to.push_back(JSONNode("", channels[last * count + c]));
+		}
+
+		commandElement.push_back(JSONNode("type", type));
+		commandElement.push_back(JSONNode("instanceId", objectId));
+		commandElement.push_back(JSONNode("duration", (FCM::U_Int32)(last - first)));
+		if (ease != 0)
+		{
+			commandElement.push_back(JSONNode("ease", ease));
+		}
+		commandElement.push_back(from);
+		commandElement.push_back(to);
+		return commandElement;
+	}
+
+	static JSONNode* GetFrameCommands(std::map<FCM::U_Int32, JSONNode*>& frameCommands, FCM::U_Int32 frame)
+	{
+		std::map<FCM::U_Int32, JSONNode*>::iterator it = frameCommands.find(frame);
+		if (it != frameCommands.end())
+		{
+			return it->second;
+		}
+
+		JSONNode* pCommands = new JSONNode(JSON_ARRAY);
+		ASSERT(pCommands);
+		pCommands->set_name("commands");
+		frameCommands[frame] = pCommands;
+		return pCommands;
+	}
+
+	// Display transforms are written as x, y, scaleX, scaleY, skewX, skewY and rotation
+	static const int DISPLAY_CHANNELS = 7;
+
+	static const char* DISPLAY_CHANNEL_NAMES[DISPLAY_CHANNELS] = { "x", "y", "sx", "sy", "kx", "ky", "r" };
+
+	// Scale and angles, in radians, are kept to 3 decimal places
+	static const double DISPLAY_QUANTUM = 1000.0;
+
+	static double Quantize(double value, double quantum)
+	{
+		return floor(value * quantum + 0.5) / quantum;
+	}
+
+	// Same decomposition and rounding the publisher used to do per Move
+	static void DecomposeDisplay(const DOM::Utils::MATRIX2D& matrix, double positionQuantum, double* channels)
+	{
+		channels[0] = Quantize(matrix.tx, positionQuantum);
+		channels[1] = Quantize(matrix.ty, positionQuantum);
+		channels[2] = Quantize(sqrt(matrix.a * matrix.a + matrix.b * matrix.b), DISPLAY_QUANTUM);
+		channels[3] = Quantize(sqrt(matrix.c * matrix.c + matrix.d * matrix.d), DISPLAY_QUANTUM);
+		channels[4] = -Quantize(atan2(matrix.d, matrix.c) - TWEEN_PI / 2, DISPLAY_QUANTUM);
+		channels[5] = Quantize(atan2(matrix.b, matrix.a), DISPLAY_QUANTUM);
+		channels[6] = 0.0;
+
+		// Equal skews are a rotation
+		if (channels[4] + channels[5] == 0.0)
+		{
+			channels[6] = channels[5];
+			channels[4] = 0.0;
+			channels[5] = 0.0;
+		}
+	}
+
+	// Only the channels that differ from the previous transform are written,
+	// returns false if there are none
+	static bool ToDisplayJSON(
+		const DOM::Utils::MATRIX2D& matrix,
+		const DOM::Utils::MATRIX2D* pPrevious,
+		double positionQuantum,
+		JSONNode& json)
+	{
+		double channels[DISPLAY_CHANNELS];
+		double previous[DISPLAY_CHANNELS];
+		DecomposeDisplay(matrix, positionQuantum, channels);
+		if (pPrevious)
+		{
+			DecomposeDisplay(*pPrevious, positionQuantum, previous);
+		}
+
+		json = JSONNode(JSON_NODE);
+		json.set_name("transform");
+		for (int c = 0; c < DISPLAY_CHANNELS; c++)
+		{
+			if (!pPrevious || channels[c] != previous[c])
+			{
+				json.push_back(JSONNode(DISPLAY_CHANNEL_NAMES[c], channels[c]));
+			}
+		}
+		return !json.empty();
+	}
+
+	static void WriteMove(
+		std::map<FCM::U_Int32, JSONNode*>& frameCommands,
+		FCM::U_Int32 frame,
+		FCM::U_Int32 objectId,
+		const DOM::Utils::MATRIX2D& matrix,
+		const DOM::Utils::MATRIX2D* pPrevious,
+		double positionQuantum)
+	{
+		JSONNode transform;
+		if (!ToDisplayJSON(matrix, pPrevious, positionQuantum, transform))
+		{
+			return;
+		}
+
+		JSONNode commandElement(JSON_NODE);
+
+		commandElement.push_back(JSONNode("type", "Move"));
+		commandElement.push_back(JSONNode("instanceId", objectId));
+		commandElement.push_back(transform);
+
+		GetFrameCommands(frameCommands, frame)->push_back(commandElement);
+	}
+
+	static void WriteColorTransform(
+		std::map<FCM::U_Int32, JSONNode*>& frameCommands,
+		FCM::U_Int32 frame,
+		FCM::U_Int32 objectId,
+		const DOM::Utils::COLOR_MATRIX& colorMatrix)
+	{
+		JSONNode commandElement(JSON_NODE);
+
+		commandElement.push_back(JSONNode("type", "ColorTransform"));
+		commandElement.push_back(JSONNode("instanceId", objectId));
+		commandElement.push_back(Utils::ToJSON("colorMatrix", colorMatrix));
+
+		GetFrameCommands(frameCommands, frame)->push_back(commandElement);
+	}
+
 	FCM::Result TimelineWriter::PlaceObject(
 		FCM::U_Int32 resId,
 		FCM::U_Int32 objectId,
@@ -41,7 +417,12 @@ namespace PixiJS
 
 		if (pMatrix)
 		{
-			commandElement.push_back(Utils::ToJSON("transform", *pMatrix));
+			JSONNode transform;
+			if (!m_animationTracks && ToDisplayJSON(*pMatrix, NULL, m_positionQuantum, transform))
+			{
+				commandElement.push_back(transform);
+			}
+			AddTransformKey(objectId, *pMatrix, true);
 		}
 
 		if (pRect)
@@ -74,7 +455,12 @@ namespace PixiJS
 
 		if (pMatrix)
 		{
-			commandElement.push_back(Utils::ToJSON("transform", *pMatrix));
+			JSONNode transform;
+			if (!m_animationTracks && ToDisplayJSON(*pMatrix, NULL, m_positionQuantum, transform))
+			{
+				commandElement.push_back(transform);
+			}
+			AddTransformKey(objectId, *pMatrix, true);
 		}
 
 		if (!instanceName.empty())
@@ -152,6 +538,8 @@ namespace PixiJS
 
 		m_pCommandArray->push_back(commandElement);
 
+		m_removeFrames[objectId] = m_FrameCount;
+
 		return FCM_SUCCESS;
 	}
 
@@ -262,6 +650,12 @@ namespace PixiJS
 		FCM::U_Int32 objectId,
 		FCM::Boolean visible)
 	{
+		if (m_animationTracks)
+		{
+			m_visibilityTracks[objectId].push_back(std::make_pair(m_FrameCount, (bool)visible));
+			return FCM_SUCCESS;
+		}
+
 		JSONNode commandElement(JSON_NODE);
 
 		commandElement.push_back(JSONNode("type", "Visibility"));
@@ -630,6 +1024,7 @@ namespace PixiJS
 				}
 
 				commandElement.push_back(*stopPointArray);
+				delete stopPointArray;
 
 			}//lineargradient
 		}
@@ -728,6 +1123,7 @@ namespace PixiJS
 				}
 
 				commandElement.push_back(*stopPointsArray);
+				delete stopPointsArray;
 
 			}//lineargradient
 		}
@@ -772,83 +1168,583 @@ namespace PixiJS
 		FCM::U_Int32 objectId,
 		const DOM::Utils::MATRIX2D& matrix)
 	{
-		JSONNode commandElement(JSON_NODE);
-		std::string transformMat;
+		// Written as tweens once the whole timeline is in
+		AddTransformKey(objectId, matrix, false);
 
-		commandElement.push_back(JSONNode("type", "Move"));
-		commandElement.push_back(JSONNode("instanceId", objectId));
-		commandElement.push_back(Utils::ToJSON("transform", matrix));
+		return FCM_SUCCESS;
+	}
 
-		m_pCommandArray->push_back(commandElement);
 
-		return FCM_SUCCESS;
+	void TimelineWriter::AddTransformKey(
+		FCM::U_Int32 objectId,
+		const DOM::Utils::MATRIX2D& matrix,
+		bool written)
+	{
+		TransformTrack& track = m_transformTracks[objectId];
+
+		// A Move on the frame of the Place replaces its transform
+		if (!track.empty() && track.back().frame == m_FrameCount)
+		{
+			track.back().matrix = matrix;
+			track.back().written = track.back().written && written;
+			return;
+		}
+
+		TRANSFORM_KEY key;
+		key.frame = m_FrameCount;
+		key.matrix = matrix;
+		key.written = written;
+		track.push_back(key);
 	}
 
 
-	FCM::Result TimelineWriter::UpdateColorTransform(
+	const TimelineWriter::TRANSFORM_KEY* TimelineWriter::HeldTransform(
 		FCM::U_Int32 objectId,
-		const DOM::Utils::COLOR_MATRIX& colorMatrix)
+		FCM::U_Int32 frame)
 	{
-		JSONNode commandElement(JSON_NODE);
+		std::map<FCM::U_Int32, TransformTrack>::iterator it = m_transformTracks.find(objectId);
+		if (it == m_transformTracks.end() || !IsAlive(objectId, frame))
+		{
+			return NULL;
+		}
 
-		commandElement.push_back(JSONNode("type", "ColorTransform"));
-		commandElement.push_back(JSONNode("instanceId", objectId));
-		commandElement.push_back(Utils::ToJSON("colorMatrix", colorMatrix));
+		// Last key on or before the frame
+		const TransformTrack& track = it->second;
+		size_t lo = 0;
+		size_t hi = track.size();
+		while (lo < hi)
+		{
+			size_t mid = (lo + hi) / 2;
+			if (track[mid].frame <= frame)
+			{
+				lo = mid + 1;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+		return lo > 0 ? &track[lo - 1] : NULL;
+	}
 
-		m_pCommandArray->push_back(commandElement);
 
-		return FCM_SUCCESS;
+	DOM::Utils::COLOR_MATRIX TimelineWriter::HeldColor(
+		FCM::U_Int32 objectId,
+		FCM::U_Int32 frame)
+	{
+		DOM::Utils::COLOR_MATRIX color;
+		memset(&color, 0, sizeof(color));
+		for (int i = 0; i < 4; i++)
+		{
+			color.matrix[i][i] = 1;
+		}
+
+		std::map<FCM::U_Int32, ColorTrack>::iterator it = m_colorTracks.find(objectId);
+		if (it != m_colorTracks.end())
+		{
+			const ColorTrack& track = it->second;
+			for (size_t i = 0; i < track.size() && track[i].frame <= frame; i++)
+			{
+				color = track[i].matrix;
+			}
+		}
+		return color;
 	}
 
 
-	FCM::Result TimelineWriter::ShowFrame(FCM::U_Int32 frameNum)
+	bool TimelineWriter::IsAlive(FCM::U_Int32 objectId, FCM::U_Int32 frame)
 	{
-		DeferUpdateMasks();
+		std::map<FCM::U_Int32, TransformTrack>::iterator it = m_transformTracks.find(objectId);
+		if (it == m_transformTracks.end() || it->second.empty() || it->second[0].frame > frame)
+		{
+			return false;
+		}
+
+		std::map<FCM::U_Int32, FCM::U_Int32>::iterator removed = m_removeFrames.find(objectId);
+		return removed == m_removeFrames.end() || removed->second > frame;
+	}
 
-		bool showFrame = false;
 
-		m_pFrameElement->push_back(JSONNode("frame", frameNum));
-		if (!m_pLabelElement->empty())
+	static bool Overlaps(
+		const std::vector<std::pair<FCM::U_Int32, FCM::U_Int32> >& spans,
+		FCM::U_Int32 first,
+		FCM::U_Int32 last)
+	{
+		for (size_t i = 0; i < spans.size(); i++)
 		{
-			m_pFrameElement->push_back(*m_pLabelElement);
-			showFrame = true;
+			if (first < spans[i].second && spans[i].first < last)
+			{
+				return true;
+			}
 		}
-		if (!m_pCommandArray->empty())
+		return false;
+	}
+
+
+	void TimelineWriter::MatchTweenSpans(const TWEEN_SPAN_LIST& spans)
+	{
+		// A keyframe tween belongs to the instance that is showing its
+		// transform, or color, on its first two frames
+		for (size_t i = 0; i < spans.size(); i++)
 		{
-			m_pFrameElement->push_back(*m_pCommandArray);
-			showFrame = true;
+			const TWEEN_SPAN& span = spans[i];
+			FCM::U_Int32 last = span.frame + span.duration;
+
+			for (std::map<FCM::U_Int32, TransformTrack>::iterator it = m_transformTracks.begin();
+				!span.matrices.empty() && it != m_transformTracks.end(); it++)
+			{
+				bool matched = !Overlaps(m_transformSpans[it->first], span.frame, last);
+				for (size_t k = 0; matched && k < span.matrices.size(); k++)
+				{
+					const TRANSFORM_KEY* pKey = HeldTransform(it->first, span.frame + (FCM::U_Int32)k);
+					matched = pKey && TransformError(pKey->matrix, span.matrices[k]) <= TWEEN_MATCH_TOLERANCE;
+				}
+				if (matched)
+				{
+					m_transformSpans[it->first].push_back(std::make_pair(span.frame, last));
+					break;
+				}
+			}
+
+			for (std::map<FCM::U_Int32, TransformTrack>::iterator it = m_transformTracks.begin();
+				!span.colors.empty() && it != m_transformTracks.end(); it++)
+			{
+				bool matched = m_colorTracks.count(it->first) > 0 &&
+					!Overlaps(m_colorSpans[it->first], span.frame, last);
+				for (size_t k = 0; matched && k < span.colors.size(); k++)
+				{
+					matched = IsAlive(it->first, span.frame + (FCM::U_Int32)k) &&
+						ColorError(HeldColor(it->first, span.frame + (FCM::U_Int32)k), span.colors[k]) <= COLOR_MATCH_TOLERANCE;
+				}
+				if (matched)
+				{
+					m_colorSpans[it->first].push_back(std::make_pair(span.frame, last));
+					break;
+				}
+			}
 		}
-		if (!m_pFrameScripts->empty())
+	}
+
+
+	void TimelineWriter::WriteTweenTracks(double tolerance)
+	{
+		std::map<FCM::U_Int32, JSONNode*> frameCommands;
+
+		for (std::map<FCM::U_Int32, TransformTrack>::iterator it = m_transformTracks.begin();
+			it != m_transformTracks.end(); it++)
 		{
-			m_pFrameElement->push_back(*m_pFrameScripts);
-			showFrame = true;
+			const TransformTrack& track = it->second;
+			TransformTrack run;
+
+			for (size_t i = 0; i < track.size(); i++)
+			{
+				const TRANSFORM_KEY& key = track[i];
+				if (!run.empty() && key.frame != run.back().frame + 1)
+				{
+					WriteTransformRun(it->first, run, tolerance, frameCommands);
+					run.clear();
+				}
+
+				// The previous transform is held up to this key, so a tween
+				// can start from it on the frame before
+				if (run.empty() && i > 0 && !key.written)
+				{
+					TRANSFORM_KEY held = track[i - 1];
+					held.frame = key.frame - 1;
+					held.written = true;
+					run.push_back(held);
+				}
+				run.push_back(key);
+			}
+
+			if (!run.empty())
+			{
+				WriteTransformRun(it->first, run, tolerance, frameCommands);
+			}
 		}
 
-		if (showFrame)
+		WriteColorTracks(frameCommands);
+
+		// Frames of the tweens go after the rest, the publisher keys them by frame
+		for (std::map<FCM::U_Int32, JSONNode*>::iterator it = frameCommands.begin();
+			it != frameCommands.end(); it++)
 		{
-			m_pFrameArray->push_back(*m_pFrameElement);
+			JSONNode frameElement(JSON_NODE);
+			frameElement.push_back(JSONNode("frame", it->first));
+			frameElement.push_back(*(it->second));
+			m_pFrameArray->push_back(frameElement);
+
+			delete it->second;
 		}
 
-		m_FrameCount++;
+		m_transformTracks.clear();
+		m_colorTracks.clear();
+		m_removeFrames.clear();
+		m_transformSpans.clear();
+		m_colorSpans.clear();
+	}
 
-		delete m_pCommandArray;
-		delete m_pFrameElement;
-		delete m_pFrameScripts;
-		delete m_pLabelElement;
 
-		m_pCommandArray = new JSONNode(JSON_ARRAY);
-		m_pCommandArray->set_name("commands");
+	void TimelineWriter::WriteTransformRun(
+		FCM::U_Int32 objectId,
+		const TransformTrack& run,
+		double tolerance,
+		std::map<FCM::U_Int32, JSONNode*>& frameCommands)
+	{
+		size_t count = run.size();
+		bool startWritten = run[0].written;
 
-		m_pFrameElement = new JSONNode(JSON_NODE);
-		ASSERT(m_pFrameElement);
+		if (tolerance < 0.0 || count < 3)
+		{
+			for (size_t i = 0; i < count; i++)
+			{
+				if (!run[i].written)
+				{
+					WriteMove(frameCommands, run[i].frame, objectId, run[i].matrix,
+						i > 0 ? &run[i - 1].matrix : NULL, m_positionQuantum);
+				}
+			}
+			return;
+		}
 
-		m_pLabelElement = new JSONNode(JSON_ARRAY);
-		m_pLabelElement->set_name("labels");
-		ASSERT(m_pLabelElement);
+		std::vector<double> channels(count * TRANSFORM_CHANNELS);
+		for (size_t i = 0; i < count; i++)
+		{
+			DecomposeTransform(run[i].matrix, &channels[i * TRANSFORM_CHANNELS]);
 
-		m_pFrameScripts = new JSONNode(JSON_ARRAY);
-		m_pFrameScripts->set_name("scripts");
-		ASSERT(m_pFrameScripts);
+			// Unwrap the angles so rotations past 180 degrees tween the long way round
+			for (int c = 4; i > 0 && c < TRANSFORM_CHANNELS; c++)
+			{
+				double prev = channels[(i - 1) * TRANSFORM_CHANNELS + c];
+				double& angle = channels[i * TRANSFORM_CHANNELS + c];
+				while (angle - prev > TWEEN_PI) angle -= 2 * TWEEN_PI;
+				while (angle - prev < -TWEEN_PI) angle += 2 * TWEEN_PI;
+			}
+		}
+
+		// Keyframe tweens split the run where they start and end
+		std::vector<size_t> splits;
+		const FrameSpans& spans = m_transformSpans[objectId];
+		for (size_t i = 0; i < spans.size(); i++)
+		{
+			for (int end = 0; end < 2; end++)
+			{
+				FCM::U_Int32 frame = end ? spans[i].second : spans[i].first;
+				if (frame > run[0].frame && frame < run[0].frame + count - 1)
+				{
+					splits.push_back(frame - run[0].frame);
+				}
+			}
+		}
+		splits.push_back(count - 1);
+		std::sort(splits.begin(), splits.end());
+
+		size_t first = 0;
+		size_t split = 0;
+		while (first + 1 < count)
+		{
+			while (splits[split] <= first)
+			{
+				split++;
+			}
+
+			int ease;
+			size_t limit = splits[split];
+			size_t good = FitSegment(channels, TRANSFORM_MODEL, first, limit, limit + 1 < count || !spans.empty(), tolerance, ease);
+
+			if (good - first < 2)
+			{
+				if (!startWritten)
+				{
+					WriteMove(frameCommands, run[first].frame, objectId, run[first].matrix,
+						first > 0 ? &run[first - 1].matrix : NULL, m_positionQuantum);
+				}
+				WriteMove(frameCommands, run[good].frame, objectId, run[good].matrix,
+					&run[good - 1].matrix, m_positionQuantum);
+			}
+			else
+			{
+				GetFrameCommands(frameCommands, run[first].frame)->push_back(
+					ToTweenJSON("Tween", objectId, channels, TRANSFORM_CHANNELS, first, good, ease));
+			}
+
+			startWritten = true;
+			first = good;
+		}
+	}
+
+
+	void TimelineWriter::WriteColorTracks(std::map<FCM::U_Int32, JSONNode*>& frameCommands)
+	{
+		for (std::map<FCM::U_Int32, ColorTrack>::iterator it = m_colorTracks.begin();
+			it != m_colorTracks.end(); it++)
+		{
+			FCM::U_Int32 objectId = it->first;
+			const ColorTrack& track = it->second;
+			const FrameSpans& spans = m_colorSpans[objectId];
+
+			// Keys the color tweens don't cover are written as they are
+			for (size_t i = 0; i < track.size(); i++)
+			{
+				bool tweened = false;
+				for (size_t j = 0; !tweened && j < spans.size(); j++)
+				{
+					tweened = track[i].frame >= spans[j].first && track[i].frame <= spans[j].second;
+				}
+				if (!tweened)
+				{
+					WriteColorTransform(frameCommands, track[i].frame, objectId, track[i].matrix);
+				}
+			}
+
+			for (size_t j = 0; j < spans.size(); j++)
+			{
+				// The color on every frame of the tween, up to the instance's removal
+				FCM::U_Int32 last = spans[j].second;
+				while (last > spans[j].first && !IsAlive(objectId, last))
+				{
+					last--;
+				}
+
+				size_t count = last - spans[j].first + 1;
+				std::vector<double> channels(count * COLOR_CHANNELS);
+				std::vector<DOM::Utils::COLOR_MATRIX> colors(count);
+				for (size_t k = 0; k < count; k++)
+				{
+					colors[k] = HeldColor(objectId, spans[j].first + (FCM::U_Int32)k);
+					DecomposeColor(colors[k], &channels[k * COLOR_CHANNELS]);
+				}
+
+				size_t first = 0;
+				while (first + 1 < count)
+				{
+					int ease;
+					size_t good = FitSegment(channels, COLOR_MODEL, first, count - 1, true, COLOR_TOLERANCE, ease);
+
+					if (good - first < 2)
+					{
+						if (first == 0)
+						{
+							WriteColorTransform(frameCommands, spans[j].first, objectId, colors[0]);
+						}
+						WriteColorTransform(frameCommands, spans[j].first + (FCM::U_Int32)good, objectId, colors[good]);
+					}
+					else
+					{
+						GetFrameCommands(frameCommands, spans[j].first + (FCM::U_Int32)first)->push_back(
+							ToTweenJSON("ColorTween", objectId, channels, COLOR_CHANNELS, first, good, ease));
+					}
+					first = good;
+				}
+				if (count == 1)
+				{
+					WriteColorTransform(frameCommands, spans[j].first, objectId, colors[0]);
+				}
+			}
+		}
+	}
+
+
+	// Frame deltas and values of one property of an instance
+	struct ANIMATION_TRACK
+	{
+		JSONNode values;
+		FCM::U_Int32 lastFrame;
+
+		ANIMATION_TRACK(const char* name) :
+			values(JSON_ARRAY),
+			lastFrame(0)
+		{
+			values.set_name(name);
+		}
+
+		void Add(FCM::U_Int32 frame, const JSONNode& value)
+		{
+			values.push_back(JSONNode("", values.empty() ? frame : frame - lastFrame));
+			values.push_back(value);
+			lastFrame = frame;
+		}
+	};
+
+
+	void TimelineWriter::WriteAnimationTracks()
+	{
+		std::set<FCM::U_Int32> objectIds;
+		for (std::map<FCM::U_Int32, TransformTrack>::iterator it = m_transformTracks.begin();
+			it != m_transformTracks.end(); it++)
+		{
+			objectIds.insert(it->first);
+		}
+		for (std::map<FCM::U_Int32, ColorTrack>::iterator it = m_colorTracks.begin();
+			it != m_colorTracks.end(); it++)
+		{
+			objectIds.insert(it->first);
+		}
+		for (std::map<FCM::U_Int32, std::vector<std::pair<FCM::U_Int32, bool> > >::iterator it = m_visibilityTracks.begin();
+			it != m_visibilityTracks.end(); it++)
+		{
+			objectIds.insert(it->first);
+		}
+
+		for (std::set<FCM::U_Int32>::iterator id = objectIds.begin(); id != objectIds.end(); id++)
+		{
+			JSONNode instanceElement(JSON_NODE);
+			instanceElement.push_back(JSONNode("instanceId", *id));
+
+			// Channels written as the publisher used to compute them from Moves
+			std::vector<ANIMATION_TRACK> transformTracks;
+			for (int c = 0; c < DISPLAY_CHANNELS; c++)
+			{
+				transformTracks.push_back(ANIMATION_TRACK(DISPLAY_CHANNEL_NAMES[c]));
+			}
+
+			const TransformTrack& transforms = m_transformTracks[*id];
+			double previous[DISPLAY_CHANNELS];
+			for (size_t i = 0; i < transforms.size(); i++)
+			{
+				double channels[DISPLAY_CHANNELS];
+				DecomposeDisplay(transforms[i].matrix, m_positionQuantum, channels);
+				for (int c = 0; c < DISPLAY_CHANNELS; c++)
+				{
+					if (i == 0 || channels[c] != previous[c])
+					{
+						transformTracks[c].Add(transforms[i].frame, JSONNode("", channels[c]));
+						previous[c] = channels[c];
+					}
+				}
+			}
+
+			// Alpha and the color transform, from the default of no change
+			ANIMATION_TRACK alphaTrack("a");
+			ANIMATION_TRACK colorTrack("c");
+			double previousAlpha = 1.0;
+			double previousColor[6] = { 1.0, 0.0, 1.0, 0.0, 1.0, 0.0 };
+
+			const ColorTrack& colors = m_colorTracks[*id];
+			for (size_t i = 0; i < colors.size(); i++)
+			{
+				const DOM::Utils::COLOR_MATRIX& matrix = colors[i].matrix;
+				double alpha = matrix.matrix[3][3] + matrix.matrix[3][4] / 255.0;
+				alpha = alpha < 0.0 ? 0.0 : (alpha > 1.0 ? 1.0 : alpha);
+				if (alpha != previousAlpha)
+				{
+					alphaTrack.Add(colors[i].frame, JSONNode("", alpha));
+					previousAlpha = alpha;
+				}
+
+				double color[6];
+				bool changed = false;
+				for (int c = 0; c < 3; c++)
+				{
+					color[c * 2] = matrix.matrix[c][c];
+					color[c * 2 + 1] = Quantize(matrix.matrix[c][4] / 255.0, 100.0);
+					changed = changed || color[c * 2] != previousColor[c * 2] ||
+						color[c * 2 + 1] != previousColor[c * 2 + 1];
+				}
+				if (changed)
+				{
+					JSONNode value(JSON_ARRAY);
+					for (int c = 0; c < 6; c++)
+					{
+						value.push_back(JSONNode("", color[c]));
+						previousColor[c] = color[c];
+					}
+					colorTrack.Add(colors[i].frame, value);
+				}
+			}
+
+			ANIMATION_TRACK visibilityTrack("v");
+			bool previousVisible = true;
+			const std::vector<std::pair<FCM::U_Int32, bool> >& visibility = m_visibilityTracks[*id];
+			for (size_t i = 0; i < visibility.size(); i++)
+			{
+				if (visibility[i].second != previousVisible)
+				{
+					visibilityTrack.Add(visibility[i].first, JSONNode("", visibility[i].second ? 1 : 0));
+					previousVisible = visibility[i].second;
+				}
+			}
+
+			transformTracks.push_back(alphaTrack);
+			transformTracks.push_back(colorTrack);
+			transformTracks.push_back(visibilityTrack);
+			for (size_t t = 0; t < transformTracks.size(); t++)
+			{
+				if (!transformTracks[t].values.empty())
+				{
+					instanceElement.push_back(transformTracks[t].values);
+				}
+			}
+
+			if (instanceElement.size() > 1)
+			{
+				m_pTrackArray->push_back(instanceElement);
+			}
+		}
+
+		m_transformTracks.clear();
+		m_colorTracks.clear();
+		m_removeFrames.clear();
+		m_visibilityTracks.clear();
+	}
+
+
+	FCM::Result TimelineWriter::UpdateColorTransform(
+		FCM::U_Int32 objectId,
+		const DOM::Utils::COLOR_MATRIX& colorMatrix)
+	{
+		// Written with the transforms, so color tweens can replace them
+		ColorTrack& track = m_colorTracks[objectId];
+		if (!track.empty() && track.back().frame == m_FrameCount)
+		{
+			track.back().matrix = colorMatrix;
+			return FCM_SUCCESS;
+		}
+
+		COLOR_KEY key;
+		key.frame = m_FrameCount;
+		key.matrix = colorMatrix;
+		track.push_back(key);
+
+		return FCM_SUCCESS;
+	}
+
+
+	// The frame shares the array's contents, so the writer starts a new one
+	// in the same node rather than deleting and allocating it again
+	static void HandOffToFrame(JSONNode& frameElement, JSONNode* pArray, const char* name)
+	{
+		frameElement.push_back(*pArray);
+		*pArray = JSONNode(JSON_ARRAY);
+		pArray->set_name(name);
+	}
+
+
+	FCM::Result TimelineWriter::ShowFrame(FCM::U_Int32 frameNum)
+	{
+		DeferUpdateMasks();
+
+		// Empty frames are skipped and keep their arrays for the next frame
+		if (!m_pLabelElement->empty() || !m_pCommandArray->empty() || !m_pFrameScripts->empty())
+		{
+			JSONNode frameElement(JSON_NODE);
+			frameElement.push_back(JSONNode("frame", frameNum));
+			if (!m_pLabelElement->empty())
+			{
+				HandOffToFrame(frameElement, m_pLabelElement, "labels");
+			}
+			if (!m_pCommandArray->empty())
+			{
+				HandOffToFrame(frameElement, m_pCommandArray, "commands");
+			}
+			if (!m_pFrameScripts->empty())
+			{
+				HandOffToFrame(frameElement, m_pFrameScripts, "scripts");
+			}
+			m_pFrameArray->push_back(frameElement);
+		}
+
+		m_FrameCount++;
 
 		return FCM_SUCCESS;
 	}
@@ -856,10 +1752,7 @@ namespace PixiJS
 
 	FCM::Result TimelineWriter::AddFrameScript(FCM::CStringRep16 pScript, FCM::U_Int32 layerNum)
 	{
-		std::string script = Utils::ToString(pScript, m_pCallback);
-		Utils::ReplaceAll(script, "\r", "");
-		Utils::ReplaceAll(script, "\n", "\\n");
-		Utils::ReplaceAll(script, "\t", "");
+		std::string script = Utils::Escape(Utils::ToString(pScript, m_pCallback), ESCAPE_SCRIPT);
 
 		// JSONNode textElem(JSON_NODE);
 
@@ -892,8 +1785,10 @@ namespace PixiJS
 	}
 
 
-	TimelineWriter::TimelineWriter(FCM::PIFCMCallback pCallback) :
-		m_pCallback(pCallback)
+	TimelineWriter::TimelineWriter(FCM::PIFCMCallback pCallback, int positionPrecision, bool animationTracks) :
+		m_animationTracks(animationTracks),
+		m_pCallback(pCallback),
+		m_positionQuantum(pow(10.0, positionPrecision))
 	{
 		m_pCommandArray = new JSONNode(JSON_ARRAY);
 		ASSERT(m_pCommandArray);
@@ -907,9 +1802,6 @@ namespace PixiJS
 		ASSERT(m_pTimelineElement);
 		m_pTimelineElement->set_name("timelines");
 
-		m_pFrameElement = new JSONNode(JSON_NODE);
-		ASSERT(m_pFrameElement);
-
 		m_pLabelElement = new JSONNode(JSON_ARRAY);
 		m_pLabelElement->set_name("labels");
 		ASSERT(m_pLabelElement);
@@ -918,6 +1810,10 @@ namespace PixiJS
 		m_pFrameScripts->set_name("scripts");
 		ASSERT(m_pFrameScripts);
 
+		m_pTrackArray = new JSONNode(JSON_ARRAY);
+		m_pTrackArray->set_name("tracks");
+		ASSERT(m_pTrackArray);
+
 		m_FrameCount = 0;
 	}
 
@@ -928,8 +1824,8 @@ namespace PixiJS
 		delete m_pFrameArray;
 		delete m_pTimelineElement;
 		delete m_pLabelElement;
-		delete m_pFrameElement;
 		delete m_pFrameScripts;
+		delete m_pTrackArray;
 	}
 
 
@@ -940,8 +1836,26 @@ namespace PixiJS
 
 
 	// void TimelineWriter::Finish(FCM::U_Int32 resId, FCM::StringRep16 pName)
-	void TimelineWriter::Finish(FCM::U_Int32 resId, FCM::StringRep16 pName, std::string name)
+	void TimelineWriter::Finish(
+		FCM::U_Int32 resId,
+		FCM::StringRep16 pName,
+		std::string name,
+		double tweenTolerance,
+		const TWEEN_SPAN_LIST* pTweenSpans /* = NULL */)
 	{
+		if (m_animationTracks)
+		{
+			WriteAnimationTracks();
+		}
+		else
+		{
+			if (pTweenSpans)
+			{
+				MatchTweenSpans(*pTweenSpans);
+			}
+			WriteTweenTracks(tweenTolerance);
+		}
+
 		if (resId != 0)
 		{
 			m_pTimelineElement->push_back(JSONNode("assetId", resId));
@@ -963,5 +1877,9 @@ namespace PixiJS
 		m_pTimelineElement->push_back(JSONNode("name", name.c_str()));
 		m_pTimelineElement->push_back(JSONNode("totalFrames", m_FrameCount));
 		m_pTimelineElement->push_back(*m_pFrameArray);
+		if (m_animationTracks)
+		{
+			m_pTimelineElement->push_back(*m_pTrackArray);
+		}
 	}
 };
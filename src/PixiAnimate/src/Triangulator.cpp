@@ -0,0 +1,780 @@
+//
+//  Triangulator.cpp
+//  PixiAnimate.mp
+//
+
+#include "Triangulator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace PixiJS
+{
+	typedef Triangulator::Node Node;
+
+	// Below this many vertices checking every point is faster than hashing
+	static const size_t HASH_THRESHOLD = 80;
+
+	// Twice the signed area of the triangle, negative when convex in ring order
+	static FCM::Double Area(const Node* p, const Node* q, const Node* r)
+	{
+		return (q->y - p->y) * (r->x - q->x) - (q->x - p->x) * (r->y - q->y);
+	}
+
+	static bool Equals(const Node* p1, const Node* p2)
+	{
+		return p1->x == p2->x && p1->y == p2->y;
+	}
+
+	static int Sign(FCM::Double value)
+	{
+		return value > 0 ? 1 : value < 0 ? -1 : 0;
+	}
+
+	static bool PointInTriangle(
+		FCM::Double ax, FCM::Double ay,
+		FCM::Double bx, FCM::Double by,
+		FCM::Double cx, FCM::Double cy,
+		FCM::Double px, FCM::Double py)
+	{
+		return (cx - px) * (ay - py) >= (ax - px) * (cy - py) &&
+			(ax - px) * (by - py) >= (bx - px) * (ay - py) &&
+			(bx - px) * (cy - py) >= (cx - px) * (by - py);
+	}
+
+	// For collinear p, q and r, if q lies on segment pr
+	static bool OnSegment(const Node* p, const Node* q, const Node* r)
+	{
+		return q->x <= std::max(p->x, r->x) && q->x >= std::min(p->x, r->x) &&
+			q->y <= std::max(p->y, r->y) && q->y >= std::min(p->y, r->y);
+	}
+
+	static bool Intersects(const Node* p1, const Node* q1, const Node* p2, const Node* q2)
+	{
+		int o1 = Sign(Area(p1, q1, p2));
+		int o2 = Sign(Area(p1, q1, q2));
+		int o3 = Sign(Area(p2, q2, p1));
+		int o4 = Sign(Area(p2, q2, q1));
+
+		if (o1 != o2 && o3 != o4)
+		{
+			return true;
+		}
+		return (o1 == 0 && OnSegment(p1, p2, q1)) ||
+			(o2 == 0 && OnSegment(p1, q2, q1)) ||
+			(o3 == 0 && OnSegment(p2, p1, q2)) ||
+			(o4 == 0 && OnSegment(p2, q1, q2));
+	}
+
+	// If diagonal ab crosses an edge of the polygon
+	static bool IntersectsPolygon(const Node* a, const Node* b)
+	{
+		const Node* p = a;
+		do
+		{
+			if (p->i != a->i && p->next->i != a->i && p->i != b->i && p->next->i != b->i &&
+				Intersects(p, p->next, a, b))
+			{
+				return true;
+			}
+			p = p->next;
+		} while (p != a);
+
+		return false;
+	}
+
+	// If diagonal ab starts inside the polygon at a
+	static bool LocallyInside(const Node* a, const Node* b)
+	{
+		return Area(a->prev, a, a->next) < 0 ?
+			Area(a, b, a->next) >= 0 && Area(a, a->prev, b) >= 0 :
+			Area(a, b, a->prev) < 0 || Area(a, a->next, b) < 0;
+	}
+
+	// If the middle of diagonal ab is inside the polygon
+	static bool MiddleInside(const Node* a, const Node* b)
+	{
+		const Node* p = a;
+		bool inside = false;
+		FCM::Double px = (a->x + b->x) / 2;
+		FCM::Double py = (a->y + b->y) / 2;
+		do
+		{
+			if (((p->y > py) != (p->next->y > py)) && p->next->y != p->y &&
+				(px < (p->next->x - p->x) * (py - p->y) / (p->next->y - p->y) + p->x))
+			{
+				inside = !inside;
+			}
+			p = p->next;
+		} while (p != a);
+
+		return inside;
+	}
+
+	// If ab can split the polygon in two without crossing it
+	static bool IsValidDiagonal(const Node* a, const Node* b)
+	{
+		return a->next->i != b->i && a->prev->i != b->i && !IntersectsPolygon(a, b) &&
+			((LocallyInside(a, b) && LocallyInside(b, a) && MiddleInside(a, b) &&
+				(Area(a->prev, a, b->prev) != 0 || Area(a, b->prev, b) != 0)) ||
+			(Equals(a, b) && Area(a->prev, a, a->next) > 0 && Area(b->prev, b, b->next) > 0));
+	}
+
+	// If the sector of m contains the sector of p, both being the same point
+	static bool SectorContainsSector(const Node* m, const Node* p)
+	{
+		return Area(m->prev, m, p->prev) < 0 && Area(p->next, m, m->next) < 0;
+	}
+
+	static void RemoveNode(Node* p)
+	{
+		p->next->prev = p->prev;
+		p->prev->next = p->next;
+
+		if (p->prevZ)
+		{
+			p->prevZ->nextZ = p->nextZ;
+		}
+		if (p->nextZ)
+		{
+			p->nextZ->prevZ = p->prevZ;
+		}
+	}
+
+	static Node* GetLeftmost(Node* start)
+	{
+		Node* p = start;
+		Node* leftmost = start;
+		do
+		{
+			if (p->x < leftmost->x || (p->x == leftmost->x && p->y < leftmost->y))
+			{
+				leftmost = p;
+			}
+			p = p->next;
+		} while (p != start);
+
+		return leftmost;
+	}
+
+	static bool CompareX(const Node* a, const Node* b)
+	{
+		return a->x < b->x;
+	}
+
+	static FCM::Double SignedArea(const std::vector<FCM::Double>& coords, size_t start, size_t end)
+	{
+		FCM::Double sum = 0;
+		for (size_t i = start, j = end - 2; i < end; i += 2)
+		{
+			sum += (coords[j] - coords[i]) * (coords[i + 1] + coords[j + 1]);
+			j = i;
+		}
+		return sum;
+	}
+
+	Triangulator::Triangulator() :
+		m_pTriangles(NULL),
+		m_minX(0),
+		m_minY(0),
+		m_invSize(0)
+	{
+	}
+
+	Triangulator::~Triangulator()
+	{
+	}
+
+	bool Triangulator::Triangulate(
+		const std::vector<FCM::Double>& coords,
+		const std::vector<FCM::U_Int32>& holes,
+		std::vector<FCM::U_Int32>& triangles)
+	{
+		size_t count = triangles.size();
+		size_t outerLen = holes.empty() ? coords.size() : (size_t)holes[0] * 2;
+
+		m_nodes.clear();
+		m_pTriangles = &triangles;
+		m_invSize = 0;
+
+		Node* outerNode = LinkedList(coords, 0, outerLen, true);
+		if (!outerNode || outerNode->next == outerNode->prev)
+		{
+			m_nodes.clear();
+			return false;
+		}
+
+		if (!holes.empty())
+		{
+			outerNode = EliminateHoles(coords, holes, outerNode);
+		}
+
+		// Hash the points on a z-order curve when the shape isn't simple
+		if (coords.size() > HASH_THRESHOLD * 2)
+		{
+			FCM::Double maxX = m_minX = coords[0];
+			FCM::Double maxY = m_minY = coords[1];
+			for (size_t i = 2; i < outerLen; i += 2)
+			{
+				m_minX = std::min(m_minX, coords[i]);
+				m_minY = std::min(m_minY, coords[i + 1]);
+				maxX = std::max(maxX, coords[i]);
+				maxY = std::max(maxY, coords[i + 1]);
+			}
+			FCM::Double size = std::max(maxX - m_minX, maxY - m_minY);
+			m_invSize = size != 0 ? 32767 / size : 0;
+		}
+
+		EarcutLinked(outerNode, 0);
+
+		m_nodes.clear();
+		m_pTriangles = NULL;
+
+		return triangles.size() > count;
+	}
+
+	// Ring of the points between start and end, in the given winding
+	Node* Triangulator::LinkedList(const std::vector<FCM::Double>& coords, size_t start, size_t end, bool clockwise)
+	{
+		Node* last = NULL;
+		if (end - start < 2)
+		{
+			return last;
+		}
+
+		if (clockwise == (SignedArea(coords, start, end) > 0))
+		{
+			for (size_t i = start; i < end; i += 2)
+			{
+				last = InsertNode((FCM::U_Int32)(i / 2), coords[i], coords[i + 1], last);
+			}
+		}
+		else
+		{
+			for (size_t i = end; i > start; i -= 2)
+			{
+				last = InsertNode((FCM::U_Int32)(i / 2 - 1), coords[i - 2], coords[i - 1], last);
+			}
+		}
+
+		// Closed paths repeat their first point
+		if (last && Equals(last, last->next))
+		{
+			RemoveNode(last);
+			last = last->next;
+		}
+		return last;
+	}
+
+	// Remove duplicate and collinear points
+	Node* Triangulator::FilterPoints(Node* start, Node* end)
+	{
+		if (!start)
+		{
+			return start;
+		}
+		if (!end)
+		{
+			end = start;
+		}
+
+		Node* p = start;
+		bool again;
+		do
+		{
+			again = false;
+
+			if (!p->steiner && (Equals(p, p->next) || Area(p->prev, p, p->next) == 0))
+			{
+				RemoveNode(p);
+				p = end = p->prev;
+				if (p == p->next)
+				{
+					break;
+				}
+				again = true;
+			}
+			else
+			{
+				p = p->next;
+			}
+		} while (again || p != end);
+
+		return end;
+	}
+
+	// Clip ears off the ring, then try harder on what's left in later passes
+	void Triangulator::EarcutLinked(Node* ear, int pass)
+	{
+		if (!ear)
+		{
+			return;
+		}
+
+		if (!pass && m_invSize)
+		{
+			IndexCurve(ear);
+		}
+
+		Node* stop = ear;
+		while (ear->prev != ear->next)
+		{
+			Node* prev = ear->prev;
+			Node* next = ear->next;
+
+			if (m_invSize ? IsEarHashed(ear) : IsEar(ear))
+			{
+				AddTriangle(prev, ear, next);
+				RemoveNode(ear);
+
+				// Skipping the next vertex leaves fewer sliver triangles
+				ear = next->next;
+				stop = next->next;
+				continue;
+			}
+
+			ear = next;
+
+			// A full loop without an ear
+			if (ear == stop)
+			{
+				if (!pass)
+				{
+					EarcutLinked(FilterPoints(ear, NULL), 1);
+				}
+				else if (pass == 1)
+				{
+					ear = CureLocalIntersections(FilterPoints(ear, NULL));
+					EarcutLinked(ear, 2);
+				}
+				else if (pass == 2)
+				{
+					SplitEarcut(ear);
+				}
+				break;
+			}
+		}
+	}
+
+	// If no other point of the ring is inside the triangle of the ear
+	bool Triangulator::IsEar(Node* ear)
+	{
+		const Node* a = ear->prev;
+		const Node* b = ear;
+		const Node* c = ear->next;
+
+		if (Area(a, b, c) >= 0)
+		{
+			return false;
+		}
+
+		FCM::Double x0 = std::min(a->x, std::min(b->x, c->x));
+		FCM::Double y0 = std::min(a->y, std::min(b->y, c->y));
+		FCM::Double x1 = std::max(a->x, std::max(b->x, c->x));
+		FCM::Double y1 = std::max(a->y, std::max(b->y, c->y));
+
+		const Node* p = c->next;
+		while (p != a)
+		{
+			if (p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 &&
+				PointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+				Area(p->prev, p, p->next) >= 0)
+			{
+				return false;
+			}
+			p = p->next;
+		}
+		return true;
+	}
+
+	// IsEar, only checking the points within the ear's bounds on the z-order curve
+	bool Triangulator::IsEarHashed(Node* ear)
+	{
+		const Node* a = ear->prev;
+		const Node* b = ear;
+		const Node* c = ear->next;
+
+		if (Area(a, b, c) >= 0)
+		{
+			return false;
+		}
+
+		FCM::Double x0 = std::min(a->x, std::min(b->x, c->x));
+		FCM::Double y0 = std::min(a->y, std::min(b->y, c->y));
+		FCM::Double x1 = std::max(a->x, std::max(b->x, c->x));
+		FCM::Double y1 = std::max(a->y, std::max(b->y, c->y));
+
+		FCM::S_Int32 minZ = ZOrder(x0, y0);
+		FCM::S_Int32 maxZ = ZOrder(x1, y1);
+
+		const Node* p = ear->prevZ;
+		const Node* n = ear->nextZ;
+
+		// Look both ways along the curve, then finish whichever side is left
+		while (p && p->z >= minZ && n && n->z <= maxZ)
+		{
+			if (p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 && p != a && p != c &&
+				PointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+				Area(p->prev, p, p->next) >= 0)
+			{
+				return false;
+			}
+			p = p->prevZ;
+
+			if (n->x >= x0 && n->x <= x1 && n->y >= y0 && n->y <= y1 && n != a && n != c &&
+				PointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, n->x, n->y) &&
+				Area(n->prev, n, n->next) >= 0)
+			{
+				return false;
+			}
+			n = n->nextZ;
+		}
+
+		while (p && p->z >= minZ)
+		{
+			if (p->x >= x0 && p->x <= x1 && p->y >= y0 && p->y <= y1 && p != a && p != c &&
+				PointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, p->x, p->y) &&
+				Area(p->prev, p, p->next) >= 0)
+			{
+				return false;
+			}
+			p = p->prevZ;
+		}
+
+		while (n && n->z <= maxZ)
+		{
+			if (n->x >= x0 && n->x <= x1 && n->y >= y0 && n->y <= y1 && n != a && n != c &&
+				PointInTriangle(a->x, a->y, b->x, b->y, c->x, c->y, n->x, n->y) &&
+				Area(n->prev, n, n->next) >= 0)
+			{
+				return false;
+			}
+			n = n->nextZ;
+		}
+		return true;
+	}
+
+	// Clip the small self-intersections a ring can be left with
+	Node* Triangulator::CureLocalIntersections(Node* start)
+	{
+		Node* p = start;
+		do
+		{
+			Node* a = p->prev;
+			Node* b = p->next->next;
+
+			if (!Equals(a, b) && Intersects(a, p, p->next, b) && LocallyInside(a, b) && LocallyInside(b, a))
+			{
+				AddTriangle(a, p, b);
+
+				RemoveNode(p);
+				RemoveNode(p->next);
+
+				p = start = b;
+			}
+			p = p->next;
+		} while (p != start);
+
+		return FilterPoints(p, NULL);
+	}
+
+	// Split the ring along a valid diagonal and triangulate both halves
+	void Triangulator::SplitEarcut(Node* start)
+	{
+		Node* a = start;
+		do
+		{
+			Node* b = a->next->next;
+			while (b != a->prev)
+			{
+				if (a->i != b->i && IsValidDiagonal(a, b))
+				{
+					Node* c = SplitPolygon(a, b);
+
+					a = FilterPoints(a, a->next);
+					c = FilterPoints(c, c->next);
+
+					EarcutLinked(a, 0);
+					EarcutLinked(c, 0);
+					return;
+				}
+				b = b->next;
+			}
+			a = a->next;
+		} while (a != start);
+	}
+
+	// Join the holes to the outline, left to right
+	Node* Triangulator::EliminateHoles(const std::vector<FCM::Double>& coords, const std::vector<FCM::U_Int32>& holes, Node* outerNode)
+	{
+		std::vector<Node*> queue;
+		queue.reserve(holes.size());
+
+		for (size_t i = 0; i < holes.size(); i++)
+		{
+			size_t start = (size_t)holes[i] * 2;
+			size_t end = i + 1 < holes.size() ? (size_t)holes[i + 1] * 2 : coords.size();
+
+			Node* list = LinkedList(coords, start, end, false);
+			if (!list)
+			{
+				continue;
+			}
+			if (list == list->next)
+			{
+				list->steiner = true;
+			}
+			queue.push_back(GetLeftmost(list));
+		}
+
+		std::stable_sort(queue.begin(), queue.end(), CompareX);
+
+		for (size_t i = 0; i < queue.size(); i++)
+		{
+			outerNode = EliminateHole(queue[i], outerNode);
+		}
+		return outerNode;
+	}
+
+	Node* Triangulator::EliminateHole(Node* hole, Node* outerNode)
+	{
+		Node* bridge = FindHoleBridge(hole, outerNode);
+		if (!bridge)
+		{
+			return outerNode;
+		}
+
+		Node* bridgeReverse = SplitPolygon(bridge, hole);
+
+		FilterPoints(bridgeReverse, bridgeReverse->next);
+		return FilterPoints(bridge, bridge->next);
+	}
+
+	// Point of the outline the hole can be joined to, David Eberly's algorithm
+	Node* Triangulator::FindHoleBridge(Node* hole, Node* outerNode)
+	{
+		Node* p = outerNode;
+		FCM::Double hx = hole->x;
+		FCM::Double hy = hole->y;
+		FCM::Double qx = -std::numeric_limits<FCM::Double>::infinity();
+		Node* m = NULL;
+
+		// Nearest segment crossed by a ray left from the hole's leftmost point
+		do
+		{
+			if (hy <= p->y && hy >= p->next->y && p->next->y != p->y)
+			{
+				FCM::Double x = p->x + (hy - p->y) * (p->next->x - p->x) / (p->next->y - p->y);
+				if (x <= hx && x > qx)
+				{
+					qx = x;
+					m = p->x < p->next->x ? p : p->next;
+					if (x == hx)
+					{
+						// The hole touches the segment
+						return m;
+					}
+				}
+			}
+			p = p->next;
+		} while (p != outerNode);
+
+		if (!m)
+		{
+			return NULL;
+		}
+
+		// Of the points inside the triangle of the hole point, the segment
+		// crossing and its end, use the one at the smallest angle to the ray
+		Node* stop = m;
+		FCM::Double mx = m->x;
+		FCM::Double my = m->y;
+		FCM::Double tanMin = std::numeric_limits<FCM::Double>::infinity();
+
+		p = m;
+		do
+		{
+			if (hx >= p->x && p->x >= mx && hx != p->x &&
+				PointInTriangle(hy < my ? hx : qx, hy, mx, my, hy < my ? qx : hx, hy, p->x, p->y))
+			{
+				FCM::Double tan = fabs(hy - p->y) / (hx - p->x);
+
+				if (LocallyInside(p, hole) &&
+					(tan < tanMin || (tan == tanMin && (p->x > m->x || (p->x == m->x && SectorContainsSector(m, p))))))
+				{
+					m = p;
+					tanMin = tan;
+				}
+			}
+			p = p->next;
+		} while (p != stop);
+
+		return m;
+	}
+
+	// Link the ring in z-order
+	void Triangulator::IndexCurve(Node* start)
+	{
+		Node* p = start;
+		do
+		{
+			if (p->z == 0)
+			{
+				p->z = ZOrder(p->x, p->y);
+			}
+			p->prevZ = p->prev;
+			p->nextZ = p->next;
+			p = p->next;
+		} while (p != start);
+
+		p->prevZ->nextZ = NULL;
+		p->prevZ = NULL;
+
+		SortLinked(p);
+	}
+
+	// Merge sort of the z links, Simon Tatham's linked list version
+	Node* Triangulator::SortLinked(Node* list)
+	{
+		int inSize = 1;
+		int numMerges;
+		do
+		{
+			Node* p = list;
+			Node* tail = NULL;
+			list = NULL;
+			numMerges = 0;
+
+			while (p)
+			{
+				numMerges++;
+
+				Node* q = p;
+				int pSize = 0;
+				for (int i = 0; i < inSize; i++)
+				{
+					pSize++;
+					q = q->nextZ;
+					if (!q)
+					{
+						break;
+					}
+				}
+				int qSize = inSize;
+
+				while (pSize > 0 || (qSize > 0 && q))
+				{
+					Node* e;
+					if (pSize != 0 && (qSize == 0 || !q || p->z <= q->z))
+					{
+						e = p;
+						p = p->nextZ;
+						pSize--;
+					}
+					else
+					{
+						e = q;
+						q = q->nextZ;
+						qSize--;
+					}
+
+					if (tail)
+					{
+						tail->nextZ = e;
+					}
+					else
+					{
+						list = e;
+					}
+					e->prevZ = tail;
+					tail = e;
+				}
+				p = q;
+			}
+			tail->nextZ = NULL;
+			inSize *= 2;
+		} while (numMerges > 1);
+
+		return list;
+	}
+
+	// Interleave the bits of the point scaled to 15 bits
+	FCM::S_Int32 Triangulator::ZOrder(FCM::Double x, FCM::Double y)
+	{
+		FCM::S_Int32 ix = (FCM::S_Int32)((x - m_minX) * m_invSize);
+		FCM::S_Int32 iy = (FCM::S_Int32)((y - m_minY) * m_invSize);
+
+		ix = (ix | (ix << 8)) & 0x00FF00FF;
+		ix = (ix | (ix << 4)) & 0x0F0F0F0F;
+		ix = (ix | (ix << 2)) & 0x33333333;
+		ix = (ix | (ix << 1)) & 0x55555555;
+
+		iy = (iy | (iy << 8)) & 0x00FF00FF;
+		iy = (iy | (iy << 4)) & 0x0F0F0F0F;
+		iy = (iy | (iy << 2)) & 0x33333333;
+		iy = (iy | (iy << 1)) & 0x55555555;
+
+		return ix | (iy << 1);
+	}
+
+	// Join a and b with a diagonal, splitting the ring in two.
+	// Returns the copy of b in the ring that doesn't hold a.
+	Node* Triangulator::SplitPolygon(Node* a, Node* b)
+	{
+		Node* a2 = InsertNode(a->i, a->x, a->y, NULL);
+		Node* b2 = InsertNode(b->i, b->x, b->y, NULL);
+		Node* an = a->next;
+		Node* bp = b->prev;
+
+		a->next = b;
+		b->prev = a;
+
+		a2->next = an;
+		an->prev = a2;
+
+		b2->next = a2;
+		a2->prev = b2;
+
+		bp->next = b2;
+		b2->prev = bp;
+
+		return b2;
+	}
+
+	Node* Triangulator::InsertNode(FCM::U_Int32 i, FCM::Double x, FCM::Double y, Node* last)
+	{
+		Node node;
+		node.i = i;
+		node.x = x;
+		node.y = y;
+		node.z = 0;
+		node.prevZ = NULL;
+		node.nextZ = NULL;
+		node.steiner = false;
+
+		m_nodes.push_back(node);
+		Node* p = &m_nodes.back();
+
+		if (!last)
+		{
+			p->prev = p;
+			p->next = p;
+		}
+		else
+		{
+			p->next = last->next;
+			p->prev = last;
+			last->next->prev = p;
+			last->next = p;
+		}
+		return p;
+	}
+
+	void Triangulator::AddTriangle(Node* a, Node* b, Node* c)
+	{
+		m_pTriangles->push_back(a->i);
+		m_pTriangles->push_back(b->i);
+		m_pTriangles->push_back(c->i);
+	}
+};
@@ -40,6 +40,8 @@
 #include <copyfile.h>
 #endif
 
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <cctype>
 #include <iomanip>
 #include <algorithm>
@@ -55,6 +57,11 @@
 #include "Application/Service/IFlashApplicationService.h"
 #include "FlashFCMPublicIDs.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ESCAPE_SSE2
+#endif
+
 /* -------------------------------------------------- Constants */
 
 #ifdef _WINDOWS
@@ -64,6 +71,86 @@ EXTERN_C IMAGE_DOS_HEADER __ImageBase;
 namespace PixiJS
 {
 	static std::string comma = ",";
+
+	// What Escape does with a byte
+	enum EscapeAction
+	{
+		ESCAPE_KEEP,
+		ESCAPE_DROP,
+		ESCAPE_NEWLINE,
+		ESCAPE_BACKSLASH,
+		ESCAPE_SEPARATOR // Lead byte of U+2028/2029 in UTF-8
+	};
+
+	// Action for each byte by EscapeMode
+	struct EscapeTable
+	{
+		unsigned char actions[2][256];
+
+		EscapeTable()
+		{
+			memset(actions, ESCAPE_KEEP, sizeof(actions));
+
+			actions[ESCAPE_SCRIPT]['\r'] = ESCAPE_DROP;
+			actions[ESCAPE_SCRIPT]['\n'] = ESCAPE_NEWLINE;
+			actions[ESCAPE_SCRIPT]['\t'] = ESCAPE_DROP;
+
+			actions[ESCAPE_TEXT]['\r'] = ESCAPE_NEWLINE;
+			actions[ESCAPE_TEXT]['\n'] = ESCAPE_NEWLINE;
+			actions[ESCAPE_TEXT]['\t'] = ESCAPE_DROP;
+			actions[ESCAPE_TEXT]['\\'] = ESCAPE_BACKSLASH;
+			actions[ESCAPE_TEXT][0xE2] = ESCAPE_SEPARATOR;
+		}
+	};
+
+	static const EscapeTable escapeTable;
+
+#ifdef ESCAPE_SSE2
+	// Bytes scanned at once for the common case of nothing to escape
+	static const size_t ESCAPE_BLOCK = 16;
+
+	// True if the block has a byte that any mode may escape
+	static bool HasEscapeCandidate(const unsigned char* pBlock)
+	{
+		__m128i chunk = _mm_loadu_si128((const __m128i*)pBlock);
+		__m128i hits = _mm_or_si128(
+			_mm_or_si128(
+				_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')),
+				_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n'))),
+			_mm_or_si128(
+				_mm_or_si128(
+					_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\t')),
+					_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))),
+				_mm_cmpeq_epi8(chunk, _mm_set1_epi8((char)0xE2))));
+		return _mm_movemask_epi8(hits) != 0;
+	}
+#endif
+
+	// Index of the next byte from start with an action, length if there is none
+	static size_t FindEscape(const unsigned char* pData, size_t start, size_t length, const unsigned char* pActions)
+	{
+		size_t i = start;
+		while (i < length)
+		{
+#ifdef ESCAPE_SSE2
+			while (i + ESCAPE_BLOCK <= length && !HasEscapeCandidate(pData + i))
+			{
+				i += ESCAPE_BLOCK;
+			}
+			size_t end = i + ESCAPE_BLOCK < length ? i + ESCAPE_BLOCK : length;
+#else
+			size_t end = length;
+#endif
+			for (; i < end; i++)
+			{
+				if (pActions[pData[i]] != ESCAPE_KEEP)
+				{
+					return i;
+				}
+			}
+		}
+		return length;
+	}
 }
 
 const std::string FixSlashes(const std::string& path) {
@@ -816,6 +903,22 @@ namespace PixiJS
 		return exists;
 	}
 
+	bool Utils::GetModifiedTime(const std::string& fileName, FCM::U_Int64& time)
+	{
+#ifdef _WINDOWS
+		struct _stat info;
+		if (_stat(FixSlashes(fileName).c_str(), &info) != 0)
+#else
+		struct stat info;
+		if (stat(fileName.c_str(), &info) != 0)
+#endif
+		{
+			return false;
+		}
+		time = (FCM::U_Int64)info.st_mtime;
+		return true;
+	}
+
 	// Removes the folder all its contents
 	FCM::Result Utils::Remove(const std::string& folder, FCM::PIFCMCallback pCallback)
 	{
@@ -1006,6 +1109,68 @@ namespace PixiJS
 		}
 	}
 
+	std::string Utils::Escape(const std::string &content, EscapeMode mode)
+	{
+		const unsigned char* pData = (const unsigned char*)content.data();
+		const unsigned char* pActions = escapeTable.actions[mode];
+		size_t length = content.length();
+
+		size_t i = FindEscape(pData, 0, length, pActions);
+		if (i == length)
+		{
+			return content;
+		}
+
+		std::string result;
+		result.reserve(length + length / 8);
+
+		size_t start = 0;
+		while (i < length)
+		{
+			result.append(content, start, i - start);
+
+			switch (pActions[pData[i]])
+			{
+				case ESCAPE_NEWLINE:
+					result.append("\\n", 2);
+					break;
+				case ESCAPE_BACKSLASH:
+					result.append("\\\\", 2);
+					break;
+				case ESCAPE_SEPARATOR:
+					// Line terminators in JS, not allowed in a string literal
+					if (i + 2 < length && pData[i + 1] == 0x80 && (pData[i + 2] == 0xA8 || pData[i + 2] == 0xA9))
+					{
+						result.append(pData[i + 2] == 0xA8 ? "\\u2028" : "\\u2029", 6);
+						i += 2;
+					}
+					else
+					{
+						result += (char)pData[i];
+					}
+					break;
+				default:
+					break;
+			}
+			start = ++i;
+			i = FindEscape(pData, i, length, pActions);
+		}
+		result.append(content, start, length - start);
+		return result;
+	}
+
+	// 64-bit FNV-1a hash of the content
+	FCM::U_Int64 Utils::Hash(const std::string &content)
+	{
+		FCM::U_Int64 hash = 14695981039346656037ULL;
+		for (size_t i = 0; i < content.length(); i++)
+		{
+			hash ^= (unsigned char)content[i];
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+
 
 	bool Utils::ToBool(const std::string& str)
 	{
@@ -1038,12 +1203,37 @@ namespace PixiJS
 
 	int Utils::RunElectron(std::string argline)
 	{
+#ifdef _WINDOWS
+		return Run("C:\\Windows\\System32\\cmd.exe /C electron " + argline, true);
+#else
+		return Run("/usr/local/bin/node /usr/local/bin/electron " + argline, true);
+#endif
+	}
+
+	int Utils::RunNode(std::string argline)
+	{
+#ifdef _WINDOWS
+		return Run("C:\\Windows\\System32\\cmd.exe /C node " + argline, true);
+#else
+		return Run("/usr/local/bin/node " + argline, true);
+#endif
+	}
+
+	bool Utils::LaunchNode(std::string argline)
+	{
+#ifdef _WINDOWS
+		return Run("C:\\Windows\\System32\\cmd.exe /C node " + argline, false) == 0;
+#else
+		return Run("/usr/local/bin/node " + argline + " > /dev/null 2>&1 &", false) == 0;
+#endif
+	}
+
+	int Utils::Run(const std::string& cmd, bool wait)
+	{
 #ifdef _WINDOWS
 		STARTUPINFO si;
 		PROCESS_INFORMATION pi;
 
-		std::string cmd = "C:\\Windows\\System32\\cmd.exe /C electron " + argline;
-
 		std::wstring wcmd;
 		wcmd.assign(cmd.begin(), cmd.end());
 
@@ -1071,6 +1261,13 @@ namespace PixiJS
 			return 1;
 		}
 
+		if (!wait)
+		{
+			CloseHandle(pi.hProcess);
+			CloseHandle(pi.hThread);
+			return 0;
+		}
+
 		// Wait until child process exits.
 		WaitForSingleObject(pi.hProcess, INFINITE);
 
@@ -1084,12 +1281,15 @@ namespace PixiJS
 		return exit_code;
 
 #else
-		std::string cmd = "/usr/local/bin/node /usr/local/bin/electron " + argline;
 		FILE *in;
 		char buff[512];
 		if (!(in = popen(cmd.c_str(), "r"))) {
 			return 1;
 		}
+		// The command backgrounds itself, the shell exits right away
+		if (!wait) {
+			return WEXITSTATUS(pclose(in));
+		}
 		while (fgets(buff, sizeof(buff), in) != NULL) {};
 		int a = pclose(in);
 		return WEXITSTATUS(a);
@@ -150,6 +150,15 @@
 //#define JSON_MEMORY_POOL 524288
 
 
+/*
+ *  JSON_NODE_POOL lets a JSONNodePool take the node allocations made on its thread while it
+ *  is open, and hand them back to the system in one go once they are all freed.  Nodes
+ *  allocated from it must be freed on the same thread.  It can't be combined with
+ *  JSON_MEMORY_POOL or JSON_MEMORY_CALLBACKS
+ */
+#define JSON_NODE_POOL
+
+
 /*
  *  JSON_MUTEX_CALLBACKS exposes functions to register callbacks to lock and unlock
  *  mutexs and functions to lock and unlock JSONNodes and all of it's children.  This 
@@ -252,6 +252,8 @@ public:
 	   #ifdef JSON_MEMORY_CALLBACKS
 		  ptr -> ~jsonChildren();
 		  libjson_free<jsonChildren>(ptr);
+	   #elif defined(JSON_NODE_POOL)
+		  json_pool_free<jsonChildren>(ptr);
 	   #else
 		  delete ptr;
 	   #endif
@@ -260,6 +262,8 @@ public:
     inline static jsonChildren * newChildren(void) {
 	   #ifdef JSON_MEMORY_CALLBACKS
 		  return new(json_malloc<jsonChildren>(1)) jsonChildren();
+	   #elif defined(JSON_NODE_POOL)
+		  return new(json_pool_malloc<jsonChildren>()) jsonChildren();
 	   #else
 		  return new jsonChildren();
 	   #endif
@@ -146,4 +146,119 @@ void JSONMemory::registerMemoryCallbacks(json_malloc_t mal, json_realloc_t real,
 }
 
 
+#endif
+
+#ifdef JSON_NODE_POOL
+
+#ifdef _MSC_VER
+    #define json_thread_local __declspec(thread)
+#else
+    #define json_thread_local __thread
+#endif
+
+#define JSON_NODE_POOL_CLASSES (JSON_NODE_POOL_MAX_BLOCK / JSON_NODE_POOL_GRAIN)
+
+//every block starts with the state it came from, 0 for the heap, the union keeps the rest aligned
+union json_pool_header {
+    JSONNodePool::state * owner;
+    double align;
+};
+
+struct JSONNodePool::state {
+    char * next;  //unused part of the newest chunk
+    char * end;
+    char * chunks;  //each chunk starts with a pointer to the one before it
+    void * freelists[JSON_NODE_POOL_CLASSES];
+    size_t live;
+    size_t reserved;
+    bool open;
+};
+
+static json_thread_local JSONNodePool::state * json_current_pool = 0;
+
+static void json_pool_release(JSONNodePool::state * s) json_nothrow {
+    while(s -> chunks){
+	   char * previous = *(char **)s -> chunks;
+	   std::free(s -> chunks);
+	   s -> chunks = previous;
+    }
+    std::free(s);
+}
+
+static inline size_t json_pool_class(size_t bytes) json_nothrow {
+    return (bytes + sizeof(json_pool_header) - 1) / JSON_NODE_POOL_GRAIN;
+}
+
+JSONNodePool::JSONNodePool(void) json_nothrow : mystate((state *)std::calloc(1, sizeof(state))), previous(json_current_pool){
+    if (mystate){
+	   mystate -> open = true;
+	   json_current_pool = mystate;
+    }
+}
+
+JSONNodePool::~JSONNodePool(void) json_nothrow {
+    if (mystate){
+	   json_current_pool = previous;
+	   mystate -> open = false;
+	   if (mystate -> live == 0){
+		  json_pool_release(mystate);
+	   }
+    }
+}
+
+size_t JSONNodePool::reserved(void) const json_nothrow {
+    return mystate ? mystate -> reserved : 0;
+}
+
+void * JSONNodePool::allocate(size_t bytes) json_nothrow {
+    state * s = json_current_pool;
+    json_pool_header * block;
+    if (json_unlikely(s == 0 || bytes + sizeof(json_pool_header) > JSON_NODE_POOL_MAX_BLOCK)){
+	   block = (json_pool_header *)std::malloc(bytes + sizeof(json_pool_header));
+	   JSON_ASSERT(block != 0, JSON_TEXT("Out of memory"));
+	   block -> owner = 0;
+	   return block + 1;
+    }
+
+    const size_t index = json_pool_class(bytes);
+    if (s -> freelists[index]){
+	   block = (json_pool_header *)s -> freelists[index];
+	   s -> freelists[index] = *(void **)block;
+    } else {
+	   const size_t size = (index + 1) * JSON_NODE_POOL_GRAIN;
+	   if (json_unlikely(s -> next + size > s -> end)){
+		  //the rest of the old chunk is dropped, it is always less than one block
+		  char * chunk = (char *)std::malloc(JSON_NODE_POOL_CHUNK);
+		  JSON_ASSERT(chunk != 0, JSON_TEXT("Out of memory"));
+		  *(char **)chunk = s -> chunks;
+		  s -> chunks = chunk;
+		  s -> next = chunk + JSON_NODE_POOL_GRAIN;
+		  s -> end = chunk + JSON_NODE_POOL_CHUNK;
+		  s -> reserved += JSON_NODE_POOL_CHUNK;
+	   }
+	   block = (json_pool_header *)s -> next;
+	   s -> next += size;
+    }
+    ++s -> live;
+    block -> owner = s;
+    return block + 1;
+}
+
+void JSONNodePool::deallocate(void * ptr, size_t bytes) json_nothrow {
+    if (json_unlikely(ptr == 0)) return;
+    json_pool_header * block = (json_pool_header *)ptr - 1;
+    state * s = block -> owner;
+    if (s == 0){
+	   std::free(block);
+	   return;
+    }
+
+    const size_t index = json_pool_class(bytes);
+    *(void **)block = s -> freelists[index];
+    s -> freelists[index] = block;
+    if (--s -> live == 0 && !s -> open){
+	   json_pool_release(s);
+    }
+}
+
 #endif
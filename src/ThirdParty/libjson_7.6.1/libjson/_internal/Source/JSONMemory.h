@@ -4,6 +4,9 @@
 #include <cstdlib> //for malloc, realloc, and free
 #include <cstring> //for memmove
 #include "JSONDebug.h"
+#ifdef JSON_NODE_POOL
+    #include "JSONMemoryPool.h"
+#endif
 
 #if defined(JSON_DEBUG) || defined(JSON_SAFE)
     #define JSON_FREE_PASSTYPE &
@@ -34,5 +34,55 @@
 
 #endif
 
+#ifdef JSON_NODE_POOL
+
+#if defined(JSON_MEMORY_POOL) || defined(JSON_MEMORY_CALLBACKS)
+    #error, JSON_NODE_POOL does not combine with JSON_MEMORY_POOL or JSON_MEMORY_CALLBACKS
+#endif
+
+#include <cstddef>
+
+//blocks are sized in steps of JSON_NODE_POOL_GRAIN, bigger allocations go to malloc
+#define JSON_NODE_POOL_GRAIN 16
+#define JSON_NODE_POOL_MAX_BLOCK 256
+#define JSON_NODE_POOL_CHUNK 65536
+
+/*
+ While one of these is open, nodes, internals and child containers allocated on its thread
+ are carved out of large chunks instead of coming from the heap one at a time.  Closing it
+ stops it taking allocations, the chunks are released together when the last block is freed,
+ so nodes may outlive the scope that opened it.  Pools nest, the newest one is used.
+ */
+class JSONNodePool {
+public:
+    JSONNodePool(void) json_nothrow;
+    ~JSONNodePool(void) json_nothrow;
+
+    //bytes of chunks the pool has reserved so far
+    size_t reserved(void) const json_nothrow;
+
+    static void * allocate(size_t bytes) json_nothrow json_hot;
+    static void deallocate(void * ptr, size_t bytes) json_nothrow json_hot;
+
+    struct state;
+private:
+    state * mystate;
+    state * previous;
+
+    JSONNodePool(const JSONNodePool &);
+    JSONNodePool & operator = (const JSONNodePool &);
+};
+
+template <typename T> static inline T * json_pool_malloc(void) json_nothrow {
+    return (T *)JSONNodePool::allocate(sizeof(T));
+}
+
+template <typename T> static inline void json_pool_free(T * ptr) json_nothrow {
+    ptr -> ~T();
+    JSONNodePool::deallocate(ptr, sizeof(T));
+}
+
+#endif
+
 #endif
 
@@ -307,6 +307,8 @@ void JSONNode::deleteJSONNode(JSONNode * ptr) json_nothrow {
 	#elif defined(JSON_MEMORY_CALLBACKS)
 		ptr -> ~JSONNode();
 		libjson_free<JSONNode>(ptr);
+	#elif defined(JSON_NODE_POOL)
+		json_pool_free<JSONNode>(ptr);
 	#else
 		delete ptr;
 	#endif
@@ -317,6 +319,8 @@ inline JSONNode * _newJSONNode(const JSONNode & orig) {
 		return new((JSONNode*)json_node_mempool.allocate()) JSONNode(orig);
 	#elif defined(JSON_MEMORY_CALLBACKS)
 		return new(json_malloc<JSONNode>(1)) JSONNode(orig);
+	#elif defined(JSON_NODE_POOL)
+		return new(json_pool_malloc<JSONNode>()) JSONNode(orig);
 	#else
 		return new JSONNode(orig);
 	#endif
@@ -338,6 +342,8 @@ JSONNode * JSONNode::newJSONNode(internalJSONNode * internal_t) {
 		return new((JSONNode*)json_node_mempool.allocate()) JSONNode(internal_t);
 	#elif defined(JSON_MEMORY_CALLBACKS)
 		return new(json_malloc<JSONNode>(1)) JSONNode(internal_t);
+	#elif defined(JSON_NODE_POOL)
+		return new(json_pool_malloc<JSONNode>()) JSONNode(internal_t);
 	#else
 		return new JSONNode(internal_t);
 	#endif
@@ -348,6 +354,8 @@ JSONNode * JSONNode::newJSONNode_Shallow(const JSONNode & orig) {
 		return new((JSONNode*)json_node_mempool.allocate()) JSONNode(true, const_cast<JSONNode &>(orig));
 	#elif defined(JSON_MEMORY_CALLBACKS)
 		return new(json_malloc<JSONNode>(1)) JSONNode(true, const_cast<JSONNode &>(orig));
+	#elif defined(JSON_NODE_POOL)
+		return new(json_pool_malloc<JSONNode>()) JSONNode(true, const_cast<JSONNode &>(orig));
 	#else
 		return new JSONNode(true, const_cast<JSONNode &>(orig));
 	#endif
@@ -46,8 +46,43 @@ static inline bool _floatsAreEqual(const json_number & one, const json_number &
     #define num_str_result s.ptr
 #endif
 
+#ifdef JSON_ISO_STRICT
+    #define EXTRA_LONG
+    #define FLOAT_STRING "%f"
+    #define LFLOAT_STRING L"%f"
+#else
+    #define EXTRA_LONG long
+    #define FLOAT_STRING "%Lf"
+    #define LFLOAT_STRING L"%Lf"
+#endif
+
+//most decimal places a number is written with, the same as FLOAT_STRING prints
+#define JSON_FLOAT_DECIMALS 6
+
 class NumberToString {
 public:
+    //writes value backwards with its last digit at runner, two digits at a time, returns the first digit
+    static json_char * _writeDigits(unsigned EXTRA_LONG long value, json_char * runner) json_nothrow {
+	   static const char pairs[] =
+		  "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+		  "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+		  "8081828384858687888990919293949596979899";
+	   while (value >= 100){
+		  const char * pair = &pairs[(value % 100) * 2];
+		  value /= 100;
+		  *runner-- = (json_char)pair[1];
+		  *runner-- = (json_char)pair[0];
+	   }
+	   if (value >= 10){
+		  const char * pair = &pairs[value * 2];
+		  *runner-- = (json_char)pair[1];
+		  *runner = (json_char)pair[0];
+		  return runner;
+	   }
+	   *runner = (json_char)value + JSON_TEXT('0');
+	   return runner;
+    }
+
     template<typename T>
     static json_string _itoa(T val) json_nothrow {		
 	   #ifdef JSON_LESS_MEMORY
@@ -70,9 +105,7 @@ public:
 	   }
 
 	   //create the string
-	   do {
-		  *runner-- = (json_char)(value % 10) + JSON_TEXT('0');
-	   } while(value /= 10);
+	   runner = _writeDigits((unsigned long)value, runner) - 1;
 	   END_MEM_SCOPE
 
 	   //if it's negative, add the negation
@@ -96,26 +129,13 @@ public:
 
 		  //create the string
 		  START_MEM_SCOPE
-			 unsigned long value = (unsigned long)val;
-			 do {
-				*runner-- = (json_char)(value % 10) + JSON_TEXT('0');
-			 } while(value /= 10);
+			 runner = _writeDigits((unsigned long)val, runner);
 		  END_MEM_SCOPE
 
-		  return json_string(runner + 1);
+		  return json_string(runner);
 	   }
     #endif
 
-    #ifdef JSON_ISO_STRICT
-	   #define EXTRA_LONG
-	   #define FLOAT_STRING "%f"
-	   #define LFLOAT_STRING L"%f"
-    #else
-	   #define EXTRA_LONG long
-	   #define FLOAT_STRING "%Lf"
-	   #define LFLOAT_STRING L"%Lf"
-    #endif
-
     static json_string _ftoa(json_number value) json_nothrow {
 	   #ifndef JSON_LIBRARY
 			//ScopeCoverage(_ftoa_coverage, 6);
@@ -129,6 +149,50 @@ public:
 			 return _itoa<long EXTRA_LONG>((long EXTRA_LONG)value);
 		  }
 
+	   EXTRA_LONG double scaled = (EXTRA_LONG double)value * 1000000.0;
+	   bool negative = scaled < 0;
+	   if (negative){
+		  scaled = -scaled;
+	   }
+
+	   //anything that fits an integer once scaled is written without printf, this also skips nan and inf
+	   if (json_likely(scaled < (EXTRA_LONG double)(std::numeric_limits<unsigned EXTRA_LONG long>::max() / 2))){
+		  unsigned EXTRA_LONG long digits = (unsigned EXTRA_LONG long)scaled;
+		  const EXTRA_LONG double rest = scaled - (EXTRA_LONG double)digits;
+
+		  //scaling can be off by an ulp, which is long double or just double (Visual C++),
+		  //so a value that close to a tie is left to printf, which rounds it exactly
+		  const EXTRA_LONG double tie = rest > 0.5 ? rest - 0.5 : 0.5 - rest;
+		  if (json_likely(tie > scaled * std::numeric_limits<EXTRA_LONG double>::epsilon() * 2)){
+			 json_char fixed_str[getLenSize<sizeof(unsigned EXTRA_LONG long)>::GETLEN + 2];
+			 json_char * runner = &fixed_str[getLenSize<sizeof(unsigned EXTRA_LONG long)>::GETLEN + 1];
+			 *runner-- = JSON_TEXT('\0');
+
+			 if (rest > 0.5){
+				++digits;
+			 }
+			 unsigned int decimals = JSON_FLOAT_DECIMALS;
+			 while (decimals != 0 && digits % 10 == 0){
+				digits /= 10;
+				--decimals;
+			 }
+			 if (decimals != 0){
+				for(unsigned int i = 0; i < decimals; ++i){
+				   *runner-- = (json_char)(digits % 10) + JSON_TEXT('0');
+				   digits /= 10;
+				}
+				*runner-- = JSON_TEXT('.');
+			 } else if (digits == 0){
+				negative = false;  //no -0
+			 }
+			 runner = _writeDigits(digits, runner);
+			 if (negative){
+				*--runner = JSON_TEXT('-');
+			 }
+			 return json_string(runner);
+		  }
+	   }
+
 	   #ifdef JSON_LESS_MEMORY
 		  json_auto<json_char> s(64);
 	   #else
@@ -673,6 +673,8 @@ void internalJSONNode::deleteInternal(internalJSONNode * ptr) json_nothrow {
 	#elif defined(JSON_MEMORY_CALLBACKS) /*<- else JSON_MEMORY_CALLBACKS */
 		ptr -> ~internalJSONNode();
 		libjson_free<internalJSONNode>(ptr);
+	#elif defined(JSON_NODE_POOL) /*<- else JSON_NODE_POOL */
+		json_pool_free<internalJSONNode>(ptr);
 	#else /*<- else */
 		delete ptr;
 	#endif /*<- */
@@ -683,6 +685,8 @@ internalJSONNode * internalJSONNode::newInternal(char mytype) {
 		return new((internalJSONNode*)json_internal_mempool.allocate()) internalJSONNode(mytype);
 	#elif defined(JSON_MEMORY_CALLBACKS) /*<- else JSON_MEMORY_CALLBACKS */
 		return new(json_malloc<internalJSONNode>(1)) internalJSONNode(mytype);
+	#elif defined(JSON_NODE_POOL) /*<- else JSON_NODE_POOL */
+		return new(json_pool_malloc<internalJSONNode>()) internalJSONNode(mytype);
 	#else /*<- else */
 		return new internalJSONNode(mytype);
 	#endif /*<- */
@@ -694,6 +698,8 @@ internalJSONNode * internalJSONNode::newInternal(const json_string & unparsed) {
 		return new((internalJSONNode*)json_internal_mempool.allocate()) internalJSONNode(unparsed);
 	#elif defined(JSON_MEMORY_CALLBACKS) /*<- else JSON_MEMORY_CALLBACKS */
 		return new(json_malloc<internalJSONNode>(1)) internalJSONNode(unparsed);
+	#elif defined(JSON_NODE_POOL) /*<- else JSON_NODE_POOL */
+		return new(json_pool_malloc<internalJSONNode>()) internalJSONNode(unparsed);
 	#else /*<- else */
 		return new internalJSONNode(unparsed);
 	#endif /*<- */
@@ -704,6 +710,8 @@ internalJSONNode * internalJSONNode::newInternal(const json_string & name_t, con
 		return new((internalJSONNode*)json_internal_mempool.allocate()) internalJSONNode(name_t, value_t);
 	#elif defined(JSON_MEMORY_CALLBACKS) /*<- else JSON_MEMORY_CALLBACKS */
 		return new(json_malloc<internalJSONNode>(1)) internalJSONNode(name_t, value_t);
+	#elif defined(JSON_NODE_POOL) /*<- else JSON_NODE_POOL */
+		return new(json_pool_malloc<internalJSONNode>()) internalJSONNode(name_t, value_t);
 	#else /*<- else */
 		return new internalJSONNode(name_t, value_t);
 	#endif /*<- */
@@ -716,6 +724,8 @@ internalJSONNode * internalJSONNode::newInternal(const internalJSONNode & orig)
 		return new((internalJSONNode*)json_internal_mempool.allocate()) internalJSONNode(orig);
 	#elif defined(JSON_MEMORY_CALLBACKS) /*<- else JSON_MEMORY_CALLBACKS */
 		return new(json_malloc<internalJSONNode>(1)) internalJSONNode(orig);
+	#elif defined(JSON_NODE_POOL) /*<- else JSON_NODE_POOL */
+		return new(json_pool_malloc<internalJSONNode>()) internalJSONNode(orig);
 	#else /*<- else */
 		return new internalJSONNode(orig);
 	#endif /*<- */
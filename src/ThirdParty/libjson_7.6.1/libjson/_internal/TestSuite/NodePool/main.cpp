@@ -0,0 +1,101 @@
+/**
+ *
+ *  Compares building, writing and freeing a large document with and without a JSONNodePool
+ *  open.  Peak memory is per process, so each mode runs on its own:
+ *
+ *	   testapp heap
+ *	   testapp pool
+ *
+ */
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <ctime>
+#include "../../../libjson.h"
+
+#ifdef _WIN32
+	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+#ifndef JSON_NODE_POOL
+#error, JSON_NODE_POOL not on
+#endif
+
+#define FRAME_COUNT 20000
+#define COMMANDS_PER_FRAME 8
+#define REPEAT_COUNT 5
+
+//shaped like a timeline the publisher writes, frames of commands of small numeric fields
+static size_t buildAndWrite(void){
+    JSONNode root(JSON_NODE);
+    JSONNode frames(JSON_ARRAY);
+    frames.set_name(JSON_TEXT("frames"));
+    for(unsigned int i = 0; i < FRAME_COUNT; ++i){
+	   JSONNode frame(JSON_NODE);
+	   frame.push_back(JSONNode(JSON_TEXT("frame"), i));
+	   JSONNode commands(JSON_ARRAY);
+	   commands.set_name(JSON_TEXT("commands"));
+	   for(unsigned int j = 0; j < COMMANDS_PER_FRAME; ++j){
+		  JSONNode command(JSON_NODE);
+		  command.push_back(JSONNode(JSON_TEXT("type"), JSON_TEXT("Move")));
+		  command.push_back(JSONNode(JSON_TEXT("instanceId"), j));
+		  command.push_back(JSONNode(JSON_TEXT("x"), i * 0.25 + j));
+		  command.push_back(JSONNode(JSON_TEXT("y"), i * 0.5 - j));
+		  command.push_back(JSONNode(JSON_TEXT("sx"), 1.0 + j * 0.125));
+		  command.push_back(JSONNode(JSON_TEXT("r"), i * 0.001));
+		  commands.push_back(command);
+	   }
+	   frame.push_back(commands);
+	   frames.push_back(frame);
+    }
+    root.push_back(frames);
+    return root.write().size();
+}
+
+static size_t peakBytes(void){
+    #ifdef _WIN32
+	   PROCESS_MEMORY_COUNTERS counters;
+	   GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+	   return counters.PeakWorkingSetSize;
+    #else
+	   struct rusage usage;
+	   getrusage(RUSAGE_SELF, &usage);
+	   #ifdef __APPLE__
+		  return usage.ru_maxrss;
+	   #else
+		  return usage.ru_maxrss * 1024;
+	   #endif
+    #endif
+}
+
+int main(int argc, char * argv[]){
+    const bool pooled = argc > 1 && strcmp(argv[1], "pool") == 0;
+    size_t written = 0;
+    size_t reserved = 0;
+
+    clock_t start = clock();
+    for(unsigned int i = 0; i < REPEAT_COUNT; ++i){
+	   if (pooled){
+		  JSONNodePool pool;
+		  written = buildAndWrite();
+		  reserved = pool.reserved();
+	   } else {
+		  written = buildAndWrite();
+	   }
+    }
+    clock_t end = clock();
+
+    cout << (pooled ? "pool" : "heap") << ": " << (double)(end - start) / CLOCKS_PER_SEC << " seconds, ";
+    cout << peakBytes() / 1024 << " KB peak, " << written << " bytes written";
+    if (pooled){
+	   cout << ", " << reserved / 1024 << " KB pooled";
+    }
+    cout << endl;
+    return 0;
+}
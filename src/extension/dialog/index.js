@@ -36,6 +36,13 @@
     var $spritesheets = $("#spritesheets");
     var $spritesheetSize = $("#spritesheetSize");
     var $spritesheetScale = $("#spritesheetScale");
+    var $reuseImages = $("#reuseImages");
+    var $tweenTolerance = $("#tweenTolerance");
+    var $nativeTweens = $("#nativeTweens");
+    var $transformPrecision = $("#transformPrecision");
+    var $animationTracks = $("#animationTracks");
+    var $triangulateFills = $("#triangulateFills");
+    var $pathTolerance = $("#pathTolerance");
 
     // Execute JSFL scripts
     function exec(script, callback)
@@ -143,6 +150,13 @@
             $stageName.value = data[SETTINGS + "StageName"];
             $spritesheetSize.value = data[SETTINGS + "SpritesheetSize"] || 1024;
             $spritesheetScale.value = data[SETTINGS + "SpritesheetScale"] || 1.0;
+            $reuseImages.checked = data[SETTINGS + "ReuseImages"] == "true";
+            $tweenTolerance.value = data[SETTINGS + "TweenTolerance"] || "0";
+            $nativeTweens.checked = data[SETTINGS + "NativeTweens"] == "true";
+            $transformPrecision.value = data[SETTINGS + "TransformPrecision"] || "3";
+            $animationTracks.checked = data[SETTINGS + "AnimationTracks"] == "true";
+            $triangulateFills.checked = data[SETTINGS + "TriangulateFills"] == "true";
+            $pathTolerance.value = data[SETTINGS + "PathTolerance"] || "0";
 
             // Global options
             $hiddenLayers.checked = data["PublishSettings.IncludeInvisibleLayer"] == "true";
@@ -186,6 +200,13 @@
         data[SETTINGS + "StageName"] = $stageName.value.toString();
         data[SETTINGS + "SpritesheetSize"] = $spritesheetSize.value.toString();
         data[SETTINGS + "SpritesheetScale"] = $spritesheetScale.value.toString();
+        data[SETTINGS + "ReuseImages"] = $reuseImages.checked.toString();
+        data[SETTINGS + "TweenTolerance"] = $tweenTolerance.value.toString();
+        data[SETTINGS + "NativeTweens"] = $nativeTweens.checked.toString();
+        data[SETTINGS + "TransformPrecision"] = $transformPrecision.value.toString();
+        data[SETTINGS + "AnimationTracks"] = $animationTracks.checked.toString();
+        data[SETTINGS + "TriangulateFills"] = $triangulateFills.checked.toString();
+        data[SETTINGS + "PathTolerance"] = $pathTolerance.value.toString();
 
         // Global options
         data["PublishSettings.IncludeInvisibleLayer"] = $hiddenLayers.checked.toString();
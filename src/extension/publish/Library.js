@@ -89,10 +89,16 @@ const Library = function(data)
     });
 
     // Convert the shapes
-    data.Shapes.forEach(function(shapeData, id)
+    data.Shapes.forEach(function(shapeData)
     {
+        // Duplicate artwork references the first shape with the same paths
+        if (shapeData.alias !== undefined)
+        {
+            map[shapeData.assetId] = map[shapeData.alias];
+            return;
+        }
         const shape = new Shape(library, shapeData);
-        shape.id = id;
+        shape.id = shapes.length;
         shapes.push(shape);
         map[shape.assetId] = shape;
     });
@@ -7,29 +7,33 @@ const mkdirp = require('mkdirp');
 const Library = require('./Library');
 const Renderer = require('./Renderer');
 const DataUtils = require('./utils/DataUtils');
-const SpritesheetBuilder = require('./SpritesheetBuilder');
 
 /**
  * The application to publish the JSON data to JS output buffer
  * @class Publisher
+ * @param {String} dataFile Path to the data file, the output is relative to it
+ * @param {Boolean} compress If the output should be compressed
+ * @param {Boolean} debug Don't delete the data file
+ * @param {String} assetsPath The path to the assets
+ * @param {Object} [data] Data already streamed from Flash, the file isn't read
  */
-let Publisher = function(dataFile, compress, debug, assetsPath)
+let Publisher = function(dataFile, compress, debug, assetsPath, data)
 {
     // Change the current directory
     process.chdir(path.dirname(dataFile));
 
     /**
-     * The data file to delete
+     * The data file to delete, null if the data was streamed
      * @property {string} _dataFile
      */
-    this._dataFile = dataFile;
+    this._dataFile = data ? null : dataFile;
 
     /** 
      * The data published from Flash
      * @property {Object} _data
      * @private
      */
-    this._data = JSON.parse(fs.readFileSync(dataFile, "utf8"));
+    this._data = data || JSON.parse(fs.readFileSync(dataFile, "utf8"));
 
     // override the compress
     if (compress)
@@ -131,10 +135,22 @@ p.exportAssets = function(done)
 
         // Add to the assets
         assetsToLoad[meta.stageName] = meta.imagesPath + filename;
+
+        // Fill meshes by shape, in the same order as the shapes file.
+        // Not a stage asset, nothing at runtime draws the meshes yet.
+        if (shapes.some(shape => shape.meshes.length))
+        {
+            const meshesFile = meta.stageName + ".meshes.json";
+            const meshes = shapes.map(shape => shape.meshes);
+            fs.writeFileSync(path.join(baseUrl, meshesFile), JSON.stringify(meshes));
+        }
     }
 
     if (meta.spritesheets && this.library.bitmaps.length)
     {
+        // Only spritesheets need Electron, don't load it for plain Node
+        const SpritesheetBuilder = require('./SpritesheetBuilder');
+
         // Create the builder
         new SpritesheetBuilder({
                 assets: assetsToLoad,
@@ -162,7 +178,7 @@ p.exportAssets = function(done)
  */
 p.destroy = function()
 {
-    if (!this.debug)
+    if (!this.debug && this._dataFile)
     {
         fs.unlinkSync(this._dataFile);
     }
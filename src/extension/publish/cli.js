@@ -0,0 +1,307 @@
+"use strict";
+
+/**
+ * Publish entry point for plain Node, used when the output doesn't
+ * need spritesheets and so doesn't need to pay for starting Electron.
+ * With --serve it stays running and takes publish jobs from the plugin.
+ */
+const minimist = require('minimist');
+const path = require('path');
+const argv = minimist(process.argv.slice(2), {
+    boolean: ['debug', 'compress', 'perf'],
+    string: ['assets', 'src', 'serve', 'token-file'],
+    default: {
+        debug: false,
+        compress: false,
+        perf: false
+    }
+});
+
+/**
+ * Quit the worker after this long without a request
+ * @property {int} IDLE_TIMEOUT
+ */
+const IDLE_TIMEOUT = 10 * 60 * 1000;
+
+/**
+ * Top-level arrays of the data, sent as frames by a streamed job
+ * @property {Array} SECTIONS
+ */
+const SECTIONS = ['Shapes', 'Bitmaps', 'Sounds', 'Texts', 'Timelines'];
+
+if (argv.serve)
+{
+    const token = readToken(argv['token-file']);
+    if (!token)
+    {
+        fail("Worker needs a token file.");
+    }
+    else
+    {
+        serve(argv.serve, token);
+    }
+}
+else if (!argv.src)
+{
+    fail("Source must be path to data output.");
+}
+else if (!/\.json$/i.test(argv.src))
+{
+    fail("Data file must be valid JSON.");
+}
+else
+{
+    // For measuring performance
+    const startTime = process.hrtime();
+    const DataUtils = require('./utils/DataUtils');
+
+    publish(argv.src, argv.debug, (err) => {
+        if (err) {
+            return fail(err);
+        }
+        // Output performance information
+        if (argv.perf)
+        {
+            const elapsed = process.hrtime(startTime);
+            let executionTime = DataUtils.toPrecision(
+                elapsed[0] + elapsed[1] / Math.pow(10, 9), 4
+            );
+            console.log(`\nExecuted in ${executionTime} seconds\n`);
+        }
+    });
+}
+
+/**
+ * Compile a data file to the output JavaScript
+ * @method publish
+ * @param {String} src Path to the data file
+ * @param {Boolean} debug Keep the data file and log the output
+ * @param {Function} done Called with an error, if any
+ * @param {Object} [data] The data, if it was streamed instead of saved to src
+ */
+function publish(src, debug, done, data)
+{
+    let publisher;
+    try
+    {
+        const Publisher = require('./Publisher');
+
+        // Create a new publisher
+        publisher = new Publisher(
+            src, // path to the javascript file
+            argv.compress, // If the output should be compressed
+            debug, // Don't delete the source file
+            argv.assets || __dirname,
+            data
+        );
+    }
+    catch(e)
+    {
+        return done(e);
+    }
+
+    // Allow override of snippets for debugging purposes
+    publisher.renderer.snippetsPath = path.resolve(
+        argv.assets || __dirname, 'snippets'
+    );
+
+    publisher.run(done);
+}
+
+/**
+ * Take publish jobs from the plugin, one JSON request per line over a
+ * local socket. The port is written to portFile once listening.
+ * A "stream" request is followed by the data as frames, each a line
+ * "<type> <name> <length>" and then <length> bytes of JSON. Fragments are
+ * parsed as they arrive, and the job runs once the "M _meta" frame is in.
+ * @method serve
+ * @param {String} portFile Path to write the port to
+ * @param {String} token Requests without it are ignored
+ */
+function serve(portFile, token)
+{
+    const net = require('net');
+    const fs = require('fs');
+    const jobs = [];
+    let busy = false;
+    let idleTimer = null;
+
+    const server = net.createServer((socket) => {
+        let chunks = [];
+        let size = 0;
+        let stream = null;
+
+        socket.on('error', () => {});
+        socket.on('data', (chunk) => {
+            chunks.push(chunk);
+            size += chunk.length;
+
+            // Wait for the whole frame before joining the chunks
+            if (stream && stream.frame && size < stream.frame.length) {
+                return;
+            }
+            let buffer = chunks.length == 1 ? chunks[0] : Buffer.concat(chunks, size);
+
+            if (!stream) {
+                const end = buffer.indexOf('\n');
+                if (end < 0) {
+                    chunks = [buffer];
+                    return;
+                }
+                let request;
+                try {
+                    request = JSON.parse(buffer.toString('utf8', 0, end));
+                }
+                catch(e) {
+                    return socket.destroy();
+                }
+                if (request.token !== token) {
+                    return socket.destroy();
+                }
+                resetIdle();
+
+                if (request.command != 'stream') {
+                    // One request per connection
+                    socket.removeAllListeners('data');
+                    return handle(request, socket);
+                }
+                stream = { request: request, data: {}, frame: null };
+                SECTIONS.forEach((name) => {
+                    stream.data[name] = [];
+                });
+                buffer = buffer.slice(end + 1);
+            }
+
+            try {
+                buffer = readFrames(buffer, stream, socket);
+            }
+            catch(e) {
+                socket.end('error ' + String(e).replace(/[\r\n]+/g, ' ') + '\n');
+                return socket.removeAllListeners('data');
+            }
+            chunks = buffer.length ? [buffer] : [];
+            size = buffer.length;
+        });
+    });
+
+    // Pull the complete frames off the buffer, returns what's left
+    function readFrames(buffer, stream, socket)
+    {
+        while (true) {
+            if (!stream.frame) {
+                const end = buffer.indexOf('\n');
+                if (end < 0) {
+                    return buffer;
+                }
+                const header = buffer.toString('utf8', 0, end).split(' ');
+                stream.frame = {
+                    type: header[0],
+                    name: header[1],
+                    length: parseInt(header[2], 10)
+                };
+                buffer = buffer.slice(end + 1);
+            }
+            if (buffer.length < stream.frame.length) {
+                return buffer;
+            }
+            const content = JSON.parse(buffer.toString('utf8', 0, stream.frame.length));
+            buffer = buffer.slice(stream.frame.length);
+
+            if (stream.frame.type == 'M') {
+                stream.data._meta = content;
+                socket.removeAllListeners('data');
+                jobs.push({ request: stream.request, data: stream.data, socket: socket });
+                next();
+                return buffer;
+            }
+            stream.data[stream.frame.name].push(content);
+            stream.frame = null;
+        }
+    }
+
+    function handle(request, socket)
+    {
+        if (request.command == 'ping') {
+            socket.end('pong\n');
+        }
+        else if (request.command == 'quit') {
+            socket.end('ok\n', shutdown);
+        }
+        else if (request.command == 'publish') {
+            jobs.push({ request: request, socket: socket });
+            next();
+        }
+        else {
+            socket.end('error Unknown command\n');
+        }
+    }
+
+    // Run the jobs one at a time, the publisher changes the working directory
+    function next()
+    {
+        if (busy || !jobs.length) {
+            return;
+        }
+        busy = true;
+        const job = jobs.shift();
+        publish(job.request.src, job.request.debug, (err) => {
+            let message = 'ok';
+            if (err) {
+                message = 'error ' + String(job.request.debug && err instanceof Error ? err.stack : err);
+            }
+            job.socket.end(message.replace(/[\r\n]+/g, ' ') + '\n');
+            busy = false;
+            resetIdle();
+            next();
+        }, job.data);
+    }
+
+    function resetIdle()
+    {
+        clearTimeout(idleTimer);
+        idleTimer = setTimeout(shutdown, IDLE_TIMEOUT);
+    }
+
+    function shutdown()
+    {
+        try {
+            // A newer worker may have replaced the file
+            if (fs.readFileSync(portFile, 'utf8') == String(server.address().port)) {
+                fs.unlinkSync(portFile);
+            }
+        }
+        catch(e) {}
+        process.exit(0);
+    }
+
+    server.listen(0, '127.0.0.1', () => {
+        fs.writeFileSync(portFile, String(server.address().port));
+        resetIdle();
+    });
+}
+
+/**
+ * Read the token the plugin wrote for the worker. The file is removed
+ * once read, so the token is only held by the two processes.
+ * @method readToken
+ * @param {String} tokenFile Path of the token file
+ * @return {String} The token, empty if it couldn't be read
+ */
+function readToken(tokenFile)
+{
+    const fs = require('fs');
+    try {
+        const token = fs.readFileSync(tokenFile, 'utf8').trim();
+        fs.unlinkSync(tokenFile);
+        return token;
+    }
+    catch(e) {
+        return '';
+    }
+}
+
+function fail(message)
+{
+    console.error(argv.debug && message instanceof Error ? message.stack : String(message));
+    process.exitCode = 1;
+}
@@ -0,0 +1,63 @@
+"use strict";
+
+const util = require('util');
+const Command = require('./Command');
+
+/**
+ * A keyframe color tween read from the document
+ * @class ColorTween
+ * @extends Command
+ * @constructor
+ * @param {Object} data The command data
+ * @param {string} data.type The type of command
+ * @param {int} data.duration Number of frames after the first
+ * @param {int} [data.ease=0] Classic tween ease, -100 (in) to 100 (out)
+ * @param {Array} data.from Start r, rA, g, gA, b, bA, a, aA
+ * @param {Array} data.to End r, rA, g, gA, b, bA, a, aA
+ * @param {int} frame
+ */
+const ColorTween = function(data, frame)
+{
+    Command.call(this, data, frame);
+
+    this.ease = this.ease || 0;
+};
+
+util.inherits(ColorTween, Command);
+
+const p = ColorTween.prototype;
+
+/**
+ * Expand back into a ColorTransform for each frame of the tween
+ * @method toCommands
+ * @return {Array<Object>} ColorTransform command data, starting with the first frame
+ */
+p.toCommands = function()
+{
+    const commands = [];
+    const from = this.from;
+    const to = this.to;
+    for (let i = 0; i <= this.duration; i++)
+    {
+        const t = i / this.duration;
+        const e = t + this.ease / 100 * t * (1 - t);
+        const v = from.map((value, j) => value + (to[j] - value) * e);
+        commands.push({
+            type: 'ColorTransform',
+            instanceId: this.instanceId,
+            colorMatrix: {
+                r: v[0],
+                rA: v[1],
+                g: v[2],
+                gA: v[3],
+                b: v[4],
+                bA: v[5],
+                a: v[6],
+                aA: v[7]
+            }
+        });
+    }
+    return commands;
+};
+
+module.exports = ColorTween;
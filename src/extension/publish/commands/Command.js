@@ -44,6 +44,7 @@ Command.create = function(data)
     const commands = {
         BlendMode: require('./BlendMode'),
         ColorTransform: require('./ColorTransform'),
+        ColorTween: require('./ColorTween'),
         Command: require('./Command'),
         Filter: require('./Filter'),
         Mask: require('./Mask'),
@@ -51,6 +52,7 @@ Command.create = function(data)
         Place: require('./Place'),
         SoundPlace: require('./SoundPlace'),
         Remove: require('./Remove'),
+        Tween: require('./Tween'),
         Visibility: require('./Visibility'),
         ZOrder: require('./ZOrder')
     };
@@ -18,8 +18,11 @@ const Place = function(data, frame)
 {
     Command.call(this, data, frame);
 
-    // Convert to matrix
-    this.transform = new Matrix(this.transform);
+    // Convert to matrix, animation tracks carry the transform instead
+    if (this.transform)
+    {
+        this.transform = new Matrix(this.transform);
+    }
 
     // Check for bounds and convert to rectangle
     if (this.bounds)
@@ -42,7 +45,10 @@ const p = Place.prototype;
  */
 p.toFrame = function(frame)
 {
-    Object.assign(frame, this.transform.toTween());
+    if (this.transform)
+    {
+        Object.assign(frame, this.transform.toTween());
+    }
     frame.bounds = this.bounds;
 };
 
@@ -0,0 +1,62 @@
+"use strict";
+
+const util = require('util');
+const Command = require('./Command');
+
+/**
+ * A run of Move commands fitted into a tween by the plugin,
+ * or a keyframe motion tween read from the document
+ * @class Tween
+ * @extends Command
+ * @constructor
+ * @param {Object} data The command data
+ * @param {string} data.type The type of command
+ * @param {int} data.duration Number of frames after the first
+ * @param {int} [data.ease=0] Classic tween ease, -100 (in) to 100 (out)
+ * @param {Array} data.from Start x, y, scaleX, scaleY, skewX, skewY
+ * @param {Array} data.to End x, y, scaleX, scaleY, skewX, skewY
+ * @param {int} frame
+ */
+const Tween = function(data, frame)
+{
+    Command.call(this, data, frame);
+
+    this.ease = this.ease || 0;
+};
+
+util.inherits(Tween, Command);
+
+const p = Tween.prototype;
+
+/**
+ * Expand back into a Move for each frame of the tween
+ * @method toCommands
+ * @return {Array<Object>} Move command data, starting with the first frame
+ */
+p.toCommands = function()
+{
+    const moves = [];
+    const from = this.from;
+    const to = this.to;
+    for (let i = 0; i <= this.duration; i++)
+    {
+        const t = i / this.duration;
+        const e = t + this.ease / 100 * t * (1 - t);
+        const v = from.map((value, j) => value + (to[j] - value) * e);
+        moves.push({
+            type: 'Move',
+            instanceId: this.instanceId,
+            transform: {
+                a: v[2] * Math.cos(v[5]),
+                b: v[2] * Math.sin(v[5]),
+                c: v[3] * Math.cos(v[4]),
+                d: v[3] * Math.sin(v[4]),
+                tx: v[0],
+                ty: v[1]
+            }
+        });
+    }
+    return moves;
+};
+
+module.exports = Tween;
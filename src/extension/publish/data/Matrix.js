@@ -6,11 +6,22 @@ const DataUtils = require('../utils/DataUtils');
  * The matrix object
  * @class Matrix
  * @constructor
- * @param {Object} matrix The transform matrix data
+ * @param {Object} matrix The transform matrix data, or the channels the
+ *        plugin already decomposed, of which a Move only has those that changed
  * @param {Boolean} compress If we should compress
  */
 const Matrix = function(matrix)
 {
+    if (matrix.a === undefined)
+    {
+        /**
+         * The decomposed channels, when they came from the plugin
+         * @property {Object} channels
+         */
+        this.channels = matrix;
+        return;
+    }
+
     /**
      * The x position
      * @property {Number} x
@@ -72,6 +83,10 @@ const p = Matrix.prototype;
  */
 p.toTween = function()
 {
+    if (this.channels)
+    {
+        return this.channels;
+    }
     return {
         x: this.x,
         y: this.y,
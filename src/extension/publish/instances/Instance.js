@@ -93,6 +93,14 @@ const Instance = function(libraryItem, id)
      * @private
      */
     this.isAnimated = false;
+
+    /**
+     * If the frames came from animation tracks, which only hold changes
+     * @property {Boolean} hasTracks
+     * @default false
+     * @private
+     */
+    this.hasTracks = false;
 };
 
 // Reference the prototype
@@ -111,6 +119,15 @@ p.addToFrame = function(frameIndex, command)
     // Convert into a typed command
     command = Command.create(command);
 
+    // Tweens are written back out a frame at a time
+    if (command.toCommands)
+    {
+        command.toCommands().forEach((frameCommand, i) => {
+            this.addToFrame(frameIndex + i, frameCommand);
+        });
+        return;
+    }
+
     if (command.type == "Place")
     {
         this.loop = !!command.loop;
@@ -159,6 +176,41 @@ p.addToFrame = function(frameIndex, command)
     }
 };
 
+/**
+ * Add the display properties written as animation tracks
+ * @method addTracks
+ * @param {Object} tracks Each property's frame deltas and values, e.g. `{x: [0, 10, 5, 20]}`
+ */
+p.addTracks = function(tracks)
+{
+    for (let k in tracks)
+    {
+        if (k == 'instanceId')
+        {
+            continue;
+        }
+        const track = tracks[k];
+        let frameIndex = 0;
+        for (let i = 0; i < track.length; i += 2)
+        {
+            frameIndex += track[i];
+            let frame = this.frames[frameIndex];
+            if (!frame)
+            {
+                frame = this.frames[frameIndex] = new Frame();
+            }
+            frame[k] = track[i + 1];
+        }
+    }
+
+    if (!this.initFrame)
+    {
+        this.initFrame = this.frames[Object.keys(this.frames)[0]] || null;
+    }
+    this.isAnimated = this.isAnimated || Object.keys(this.frames).length > 1;
+    this.hasTracks = true;
+};
+
 /**
  * Get the duration of this item on the stage
  * @method getDuration
@@ -215,8 +267,8 @@ p.getFrames = function(compress)
             continue;
         }
 
-        // De-duplicate the animated properties
-        for (let i = 0, len = allKeys.length; i < len; i++) 
+        // De-duplicate the animated properties, tracks only hold changes
+        for (let i = 0, len = allKeys.length; !this.hasTracks && i < len; i++) 
         {
             let k = allKeys[i];
 
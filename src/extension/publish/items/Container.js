@@ -145,6 +145,19 @@ p.getChildren = function()
             }
         });
     });
+
+    // Display properties written as animation tracks rather than commands
+    if (this.tracks)
+    {
+        this.tracks.forEach(function(track)
+        {
+            const instance = instancesMap[track.instanceId];
+            if (instance)
+            {
+                instance.addTracks(track);
+            }
+        });
+    }
 };
 
 /**
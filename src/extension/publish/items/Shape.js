@@ -27,6 +27,7 @@ const Shape = function(library, data)
     this.name = "";
 
     let draw = [];
+    let meshes = [];
 
     // Conver the data into drawing commands
     for(let j = 0, len = this.paths.length; j < len; j++) 
@@ -51,33 +52,53 @@ const Shape = function(library, data)
             }
             draw.push("s", path.thickness, color, alpha);
         } 
-        else if (gradient)
+        else
         {
-            draw.push("f", 
-                this.toColor(gradient.stop[0].stopColor), 
-                gradient.stop[0].stopOpacity
-            );
-        }
-        else if (path.image) // bitmap fill as black
-        {
-            draw.push("f", 0, 1);
-        }
-        else // normal fills
-        {
-            draw.push("f", this.toColor(path.color), path.alpha);
-        }
+            let color, alpha;
+            if (gradient)
+            {
+                color = this.toColor(gradient.stop[0].stopColor);
+                alpha = gradient.stop[0].stopOpacity;
+            }
+            else if (path.image) // bitmap fill as black
+            {
+                color = 0;
+                alpha = 1;
+            }
+            else // normal fills
+            {
+                color = this.toColor(path.color);
+                alpha = path.alpha;
+            }
+            draw.push("f", color, alpha);
 
-        path.d.forEach(function(command, k, commands) 
-        {
-            if (typeof command == "number") 
+            // Triangulated by the plugin when Triangulate Fills is on
+            if (path.mesh)
             {
-                // round the number
-                commands[k] = Math.round(command * 100) / 100;
+                let mesh = {
+                    color: color,
+                    alpha: alpha,
+                    vertices: path.mesh.vertices,
+                    indices: path.mesh.indices
+                };
+                // Baked gradients are drawn from the gradient atlas instead
+                if (path.mesh.uvs)
+                {
+                    mesh.uvs = path.mesh.uvs;
+                }
+                // Bitmap fills are drawn from their image, repeated or with stretched edges
+                if (path.mesh.image)
+                {
+                    mesh.image = path.mesh.image;
+                    mesh.src = path.image.src;
+                    mesh.repeat = path.mesh.repeat;
+                }
+                meshes.push(mesh);
             }
-        });
+        }
 
-        // Add the draw commands
-        draw.push.apply(draw, path.d)
+        // Add the draw commands, already rounded to 2 decimals
+        draw.push.apply(draw, DataUtils.decodePath(path.d));
     }
 
     /**
@@ -85,6 +106,15 @@ const Shape = function(library, data)
      * @property {Array} draw
      */
     this.draw = draw;
+
+    /**
+     * The fill meshes, base64 Float32 x/y vertices and Uint16 triangle indices.
+     * Gradient fills also have Float32 uvs, in pixels of the plugin's gradient
+     * atlas. The atlas image isn't written until the runtime draws meshes.
+     * Bitmap fills have uvs from 0 to 1 across the image they name.
+     * @property {Array} meshes
+     */
+    this.meshes = meshes;
 };
 
 // Reference to the prototype
@@ -1,5 +1,12 @@
 "use strict";
 
+/**
+ * Draw command for each opcode in the packed path data
+ * @property {Array} PATH_COMMANDS
+ * @private
+ */
+const PATH_COMMANDS = ["m", "l", "q", "c", "h"];
+
 /**
  * Data utilities
  * @class DataUtils
@@ -20,6 +27,65 @@ var DataUtils = {
         return Math.round(val * num) / num;
     },
 
+    /**
+     * Decode the packed path data from the publisher into draw commands.
+     * The data is base64 opcodes, each followed by its points as zigzag
+     * varint deltas in hundredths of a pixel.
+     * @method decodePath
+     * @static
+     * @param {String} data Base64 path data
+     * @return {Array} Draw commands, e.g., `["m", 0, 0, "l", 10.5, 0, "c"]`
+     */
+    decodePath: function(data)
+    {
+        const bytes = Buffer.from(data, 'base64');
+        const len = bytes.length;
+        const commands = [];
+        let i = 0;
+        let x = 0;
+        let y = 0;
+
+        const readValue = function()
+        {
+            let bits = 0;
+            let shift = 0;
+            let byte;
+            do
+            {
+                byte = bytes[i++];
+                bits |= (byte & 0x7f) << shift;
+                shift += 7;
+            }
+            while (byte & 0x80);
+            return (bits >>> 1) ^ -(bits & 1);
+        };
+
+        const readPoint = function()
+        {
+            x += readValue();
+            y += readValue();
+            commands.push(x / 100, y / 100);
+        };
+
+        while (i < len)
+        {
+            const op = bytes[i++];
+            commands.push(PATH_COMMANDS[op]);
+
+            // moveTo and lineTo have one point, quadraticCurveTo has two
+            if (op === 0 || op === 1)
+            {
+                readPoint();
+            }
+            else if (op === 2)
+            {
+                readPoint();
+                readPoint();
+            }
+        }
+        return commands;
+    },
+
     /**
      * Replace the key names with un-quoted strings
      * @method stringifySimple